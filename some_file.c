@@ -36,6 +36,7 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 #include <xio_os.h>
+#include <sys/eventfd.h>
 #include "libxio.h"
 #include "xio_log.h"
 #include "xio_common.h"
@@ -54,6 +55,31 @@
 #include "xio_mem.h"
 
 extern struct xio_ucx_options ucx_options;
+extern uint64_t ucx_tx_spin_wasted;
+extern uint64_t ucx_batch_grow_cnt;
+extern uint64_t ucx_batch_shrink_cnt;
+extern uint64_t ucx_tx_sendmsg_cnt;
+
+/*---------------------------------------------------------------------------*/
+/* xio_ucx_tx_spin_update						     */
+/*---------------------------------------------------------------------------*/
+static inline void xio_ucx_tx_spin_update(struct xio_ucx_transport *ucx_hndl,
+					  int spins, int drained)
+{
+	int budget = ucx_hndl->tx_spin_budget;
+
+	if (drained) {
+		/* the socket drained after "spins" retries - keep room for
+		 * twice that, averaged with the previous budget
+		 */
+		budget = (budget + 2 * spins) / 2;
+	} else {
+		__sync_fetch_and_add(&ucx_tx_spin_wasted, spins);
+		budget /= 2;
+	}
+
+	ucx_hndl->tx_spin_budget = max(1, min(budget, TX_EAGAIN_RETRY));
+}
 
 /*---------------------------------------------------------------------------*/
 /* xio_ucx_send_work                                                         */
@@ -91,27 +117,46 @@ static int xio_ucx_send_work(int fd, void **buf, uint32_t *len, int block)
 /*---------------------------------------------------------------------------*/
 /* xio_ucx_sendmsg_work                                                      */
 /*---------------------------------------------------------------------------*/
-static int xio_ucx_sendmsg_work(int fd,
+static int xio_ucx_sendmsg_work(struct xio_ucx_transport *ucx_hndl,
+				int fd,
 				struct xio_ucx_work_req *xio_send,
-				int block)
+				int block, size_t max_bytes)
 {
 	int			retval = 0, tmp_bytes, sent_bytes = 0;
-	int			eagain_count = TX_EAGAIN_RETRY;
+	int			spins = 0;
 	unsigned int		i;
 
+	if (!ucx_hndl->tx_spin_budget)
+		ucx_hndl->tx_spin_budget = TX_EAGAIN_RETRY;
+
 	while (xio_send->tot_iov_byte_len) {
 		retval = sendmsg(fd, &xio_send->msg, MSG_NOSIGNAL);
+		__sync_fetch_and_add(&ucx_tx_sendmsg_cnt, 1);
 		if (retval < 0) {
 			if (xio_get_last_socket_error() != XIO_EAGAIN) {
 				xio_set_error(xio_get_last_socket_error());
 				DEBUG_LOG("sendmsg failed. (errno=%d)\n",
 					  xio_get_last_socket_error());
 				return -1;
-			} else if (!block && (eagain_count-- == 0)) {
+			}
+			if (spins++ < ucx_hndl->tx_spin_budget)
+				continue;
+
+			/* peer is slow - stop spinning, the caller waits for
+			 * POLLOUT on the event loop. blocking callers keep
+			 * spinning as before
+			 */
+			xio_ucx_tx_spin_update(ucx_hndl, spins, 0);
+			spins = 0;
+			if (!block) {
 				xio_set_error(xio_get_last_socket_error());
 				return -1;
 			}
 		} else {
+			if (spins) {
+				xio_ucx_tx_spin_update(ucx_hndl, spins, 1);
+				spins = 0;
+			}
 			sent_bytes += retval;
 			xio_send->tot_iov_byte_len -= retval;
 
@@ -138,14 +183,47 @@ static int xio_ucx_sendmsg_work(int fd,
 					break;
 				}
 			}
-
-			eagain_count = TX_EAGAIN_RETRY;
+			/* caller's byte budget is used up - the iov is left
+			 * at the unsent remainder for the next pass
+			 */
+			if (max_bytes && (size_t)sent_bytes >= max_bytes)
+				break;
 		}
 	}
 
 	return sent_bytes;
 }
 
+/*---------------------------------------------------------------------------*/
+/* xio_ucx_set_tx_blocked						     */
+/*---------------------------------------------------------------------------*/
+static void xio_ucx_set_tx_blocked(struct xio_ucx_transport *ucx_hndl)
+{
+	/* POLLOUT is already requested */
+	if (ucx_hndl->tx_blocked)
+		return;
+
+	ucx_hndl->tx_blocked = 1;
+	xio_ucx_sockbuf_tune(ucx_hndl, SO_SNDBUF, 1);
+
+	/* the POLLOUT handler clears tx_blocked and runs xmit again */
+	if (xio_ucx_single_sock_set_pollout(ucx_hndl, 1) != 0)
+		ERROR_LOG("arming POLLOUT failed. (errno=%d %m)\n",
+			  xio_get_last_socket_error());
+}
+
+/*---------------------------------------------------------------------------*/
+/* xio_ucx_rx_credits							     */
+/*---------------------------------------------------------------------------*/
+static inline uint32_t xio_ucx_rx_credits(void)
+{
+	/* requests we can hold at once; zero tells the peer not to count */
+	if (!ucx_options.ucx_flow_credits)
+		return 0;
+
+	return g_options.rcv_queue_depth_msgs;
+}
+
 /*---------------------------------------------------------------------------*/
 /* xio_ucx_write_setup_msg						     */
 /*---------------------------------------------------------------------------*/
@@ -154,6 +232,12 @@ static void xio_ucx_write_setup_msg(struct xio_ucx_transport *ucx_hndl,
 				    struct xio_ucx_setup_msg *msg)
 {
 	struct xio_ucx_setup_msg	*tmp_msg;
+	struct xio_ucx_setup_ext	ext = { 0 }, *tmp_ext;
+
+	ext.rx_credits = xio_ucx_rx_credits();
+	if (ext.rx_credits)
+		ext.caps |= XIO_UCX_SETUP_CAP_CREDITS;
+
 	/* set the mbuf after tlv header */
 	xio_mbuf_set_val_start(&task->mbuf);
 
@@ -180,6 +264,18 @@ static void xio_ucx_write_setup_msg(struct xio_ucx_transport *ucx_hndl,
 			     64);
 #endif
 	xio_mbuf_inc(&task->mbuf, sizeof(struct xio_ucx_setup_msg));
+
+	/* optional trailer - peers that predate it never look past the
+	 * fixed setup message, so it is only sent when there is
+	 * something to say
+	 */
+	if (ext.caps) {
+		tmp_ext = (struct xio_ucx_setup_ext *)
+				xio_mbuf_get_curr_ptr(&task->mbuf);
+		PACK_LVAL(&ext, tmp_ext, caps);
+		PACK_LVAL(&ext, tmp_ext, rx_credits);
+		xio_mbuf_inc(&task->mbuf, sizeof(struct xio_ucx_setup_ext));
+	}
 }
 
 /*---------------------------------------------------------------------------*/
@@ -190,6 +286,8 @@ static void xio_ucx_read_setup_msg(struct xio_ucx_transport *ucx_hndl,
 				   struct xio_ucx_setup_msg *msg)
 {
 	struct xio_ucx_setup_msg	*tmp_msg;
+	struct xio_ucx_setup_ext	ext, *tmp_ext;
+
 	/* set the mbuf after tlv header */
 	xio_mbuf_set_val_start(&task->mbuf);
 
@@ -216,6 +314,48 @@ static void xio_ucx_read_setup_msg(struct xio_ucx_transport *ucx_hndl,
 			     64);
 #endif
 	xio_mbuf_inc(&task->mbuf, sizeof(struct xio_ucx_setup_msg));
+
+	/* no trailer (older peer) or no credit capability means the peer
+	 * does not count - send without a limit
+	 */
+	ucx_hndl->peer_rx_credits = 0;
+	if (task->mbuf.tlv.len < xio_mbuf_tlv_payload_len(&task->mbuf) +
+				 sizeof(struct xio_ucx_setup_ext))
+		return;
+
+	tmp_ext = (struct xio_ucx_setup_ext *)
+			xio_mbuf_get_curr_ptr(&task->mbuf);
+	UNPACK_LVAL(tmp_ext, &ext, caps);
+	UNPACK_LVAL(tmp_ext, &ext, rx_credits);
+	xio_mbuf_inc(&task->mbuf, sizeof(struct xio_ucx_setup_ext));
+
+	if (ext.caps & XIO_UCX_SETUP_CAP_CREDITS)
+		ucx_hndl->peer_rx_credits = ext.rx_credits;
+}
+
+/*---------------------------------------------------------------------------*/
+/* xio_ucx_send_setup_work						     */
+/*---------------------------------------------------------------------------*/
+static int xio_ucx_send_setup_work(struct xio_ucx_transport *ucx_hndl,
+				   struct xio_task *task)
+{
+	XIO_TO_UCX_TASK(task, ucx_task);
+
+	if (xio_ucx_sendmsg_work(ucx_hndl, ucx_hndl->tcp_sock.cfd,
+				 &ucx_task->txd, 0, 0) >= 0) {
+		ucx_hndl->tx_setup_task = NULL;
+		return 0;
+	}
+	if (xio_errno() != XIO_EAGAIN)
+		return -1;
+
+	/* socket full - xmit finishes it from the POLLOUT handler,
+	 * ahead of anything on tx_ready
+	 */
+	ucx_hndl->tx_setup_task = task;
+	xio_ucx_set_tx_blocked(ucx_hndl);
+
+	return 0;
 }
 
 /*---------------------------------------------------------------------------*/
@@ -254,11 +394,15 @@ static int xio_ucx_send_setup_req(struct xio_ucx_transport *ucx_hndl,
 
 	ucx_task->out_ucx_op		 = XIO_UCX_SEND;
 
-	xio_task_addref(task);
+	if (xio_ucx_send_setup_work(ucx_hndl, task) < 0) {
+		ERROR_LOG("ucx send setup request failed\n");
+		return -1;
+	}
 
-	xio_ucx_sendmsg_work(ucx_hndl->tcp_sock.cfd, &ucx_task->txd, 1);
+	xio_task_addref(task);
 
 	list_move_tail(&task->tasks_list_entry, &ucx_hndl->in_flight_list);
+	ucx_hndl->setup_task = task;
 
 	return 0;
 }
@@ -299,7 +443,10 @@ static int xio_ucx_send_setup_rsp(struct xio_ucx_transport *ucx_hndl,
 
 	ucx_task->out_ucx_op		 = XIO_UCX_SEND;
 
-	xio_ucx_sendmsg_work(ucx_hndl->tcp_sock.cfd, &ucx_task->txd, 1);
+	if (xio_ucx_send_setup_work(ucx_hndl, task) < 0) {
+		ERROR_LOG("ucx send setup response failed\n");
+		return -1;
+	}
 
 	list_move(&task->tasks_list_entry, &ucx_hndl->in_flight_list);
 
@@ -319,18 +466,11 @@ static int xio_ucx_on_setup_msg(struct xio_ucx_transport *ucx_hndl,
 	DEBUG_LOG("xio_ucx_on_setup_msg\n");
 
 	if (ucx_hndl->base.is_client) {
-		struct xio_task *sender_task = NULL;
+		struct xio_task *sender_task = ucx_hndl->setup_task;
 
-		if (!list_empty(&ucx_hndl->in_flight_list))
-			sender_task = list_first_entry(
-					&ucx_hndl->in_flight_list,
-					struct xio_task,  tasks_list_entry);
-		else if (!list_empty(&ucx_hndl->tx_comp_list))
-			sender_task = list_first_entry(
-					&ucx_hndl->tx_comp_list,
-					struct xio_task,  tasks_list_entry);
-		else
+		if (!sender_task)
 			ERROR_LOG("could not find sender task\n");
+		ucx_hndl->setup_task = NULL;
 
 		task->sender_task = sender_task;
 		xio_ucx_read_setup_msg(ucx_hndl, task, rsp);
@@ -354,6 +494,7 @@ static int xio_ucx_on_setup_msg(struct xio_ucx_transport *ucx_hndl,
 	ucx_hndl->peer_max_header      = rsp->max_header_len;
 
 	ucx_hndl->sn = 0;
+	ucx_hndl->tx_credits = ucx_hndl->peer_rx_credits;
 
 	ucx_hndl->state = XIO_TRANSPORT_STATE_CONNECTED;
 
@@ -382,15 +523,17 @@ int xio_ucx_send_connect_msg(int fd, struct xio_ucx_connect_msg *msg)
 	PACK_LVAL(msg, &smsg, length);
 	memcpy(smsg.data, msg->data, msg->length);
 
-	retval = xio_ucx_send_work(fd, &buf, &size, 1);
+	retval = xio_ucx_send_work(fd, &buf, &size, 0);
 	if (retval < 0) {
-		if (xio_get_last_socket_error() == XIO_EAGAIN) {
-			/* ORK todo set event */
-		} else {
-			ERROR_LOG("send return with %d. (errno=%d %m)\n",
-				  retval, xio_get_last_socket_error());
-			return retval;
+		if (xio_get_last_socket_error() == XIO_EAGAIN &&
+		    size == sizeof(struct xio_ucx_connect_msg)) {
+			/* nothing went out - the caller waits for POLLOUT */
+			xio_set_error(XIO_EAGAIN);
+			return 1;
 		}
+		ERROR_LOG("send return with %d. (errno=%d %m)\n",
+			  retval, xio_get_last_socket_error());
+		return retval;
 	}
 	return 0;
 }
@@ -547,13 +690,19 @@ static int xio_ucx_prep_req_header(struct xio_ucx_transport *ucx_hndl,
 
 	ucx_task->txd.ctl_msg_len = xio_mbuf_tlv_len(&task->mbuf);
 
-	/* write the payload header */
+	/* write the payload header - a NULL base only reserves the room,
+	 * the caller serializes into the mbuf itself
+	 */
 	if (ulp_hdr_len) {
-		if (xio_mbuf_write_array(
-		    &task->mbuf,
-		    task->omsg->out.header.iov_base,
-		    task->omsg->out.header.iov_len) != 0)
+		if (!task->omsg->out.header.iov_base) {
+			if (xio_mbuf_inc(&task->mbuf, ulp_hdr_len) != 0)
+				goto cleanup;
+		} else if (xio_mbuf_write_array(
+			   &task->mbuf,
+			   task->omsg->out.header.iov_base,
+			   task->omsg->out.header.iov_len) != 0) {
 			goto cleanup;
+		}
 	}
 
 	/* write the pad between header and data */
@@ -586,9 +735,13 @@ static int xio_ucx_write_send_data(
 	sgtbl_ops	= (struct xio_sg_table_ops *)
 				xio_sg_table_ops_get(task->omsg->out.sgl_type);
 
-	/* user provided mr */
+	/* user provided mr - small payloads are still copied so the
+	 * whole message is one iovec and more of them fit a sendmsg
+	 */
 	sg = sge_first(sgtbl_ops, sgtbl);
-	if (sge_mr(sgtbl_ops, sg) || !ucx_options.enable_mr_check) {
+	if ((sge_mr(sgtbl_ops, sg) || !ucx_options.enable_mr_check) &&
+	    tbl_length(sgtbl_ops, sgtbl) >
+			(size_t)ucx_options.ucx_tx_copy_threshold) {
 		for_each_sge(sgtbl, sgtbl_ops, sg, i) {
 			ucx_task->txd.msg_iov[i + 1].iov_base =
 						sge_addr(sgtbl_ops, sg);
@@ -793,6 +946,45 @@ cleanup:
 	return -1;
 }
 
+/*---------------------------------------------------------------------------*/
+/* xio_ucx_wc_capture							     */
+/*---------------------------------------------------------------------------*/
+static int xio_ucx_wc_capture(struct xio_ucx_transport *ucx_hndl,
+			      struct xio_task *task, enum xio_wc_op op)
+{
+	struct xio_transport_wc	*wc;
+	struct xio_vmsg		*vmsg = NULL;
+	struct xio_sg_table_ops	*sgtbl_ops;
+	void			*sgtbl;
+
+	/* only inside xio_ucx_poll_completions, and only while the
+	 * caller's array has room - overflow goes to the observer
+	 */
+	if (!ucx_hndl->poll_wc ||
+	    ucx_hndl->poll_wc_nr == ucx_hndl->poll_wc_max)
+		return 0;
+
+	if (op == XIO_WC_OP_RECV)
+		vmsg = &task->imsg.in;
+	else if (task->omsg)
+		vmsg = &task->omsg->out;
+
+	wc = &ucx_hndl->poll_wc[ucx_hndl->poll_wc_nr++];
+	wc->task	= task;
+	wc->op		= op;
+	wc->status	= task->status;
+	wc->bytes	= 0;
+	if (vmsg) {
+		sgtbl		= xio_sg_table_get(vmsg);
+		sgtbl_ops	= (struct xio_sg_table_ops *)
+					xio_sg_table_ops_get(vmsg->sgl_type);
+		wc->bytes	= vmsg->header.iov_len +
+				  tbl_length(sgtbl_ops, sgtbl);
+	}
+
+	return 1;
+}
+
 /*---------------------------------------------------------------------------*/
 /* xio_ucx_on_rsp_send_comp						     */
 /*---------------------------------------------------------------------------*/
@@ -806,6 +998,9 @@ static int xio_ucx_on_rsp_send_comp(struct xio_ucx_transport *ucx_hndl,
 		return 0;
 	}
 
+	if (xio_ucx_wc_capture(ucx_hndl, task, XIO_WC_OP_SEND))
+		return 0;
+
 	event_data.msg.op	= XIO_WC_OP_SEND;
 	event_data.msg.task	= task;
 
@@ -827,6 +1022,9 @@ static int xio_ucx_on_req_send_comp(struct xio_ucx_transport *ucx_hndl,
 	if (IS_CANCEL(task->tlv_type))
 		return 0;
 
+	if (xio_ucx_wc_capture(ucx_hndl, task, XIO_WC_OP_SEND))
+		return 0;
+
 	event_data.msg.op	= XIO_WC_OP_SEND;
 	event_data.msg.task	= task;
 
@@ -886,6 +1084,55 @@ static void xio_ucx_tx_completion_handler(void *xio_task)
     }
 }
 
+/*---------------------------------------------------------------------------*/
+/* xio_ucx_tx_comp_deadline						     */
+/*---------------------------------------------------------------------------*/
+static void xio_ucx_tx_comp_deadline(void *data)
+{
+	struct xio_ucx_transport *ucx_hndl = (struct xio_ucx_transport *)data;
+	struct xio_task		 *task;
+	struct xio_ucx_task	 *ucx_task;
+
+	/* the batch never filled - retire whatever went out so far */
+	if (!ucx_hndl->tx_comp_cnt || list_empty(&ucx_hndl->in_flight_list))
+		return;
+
+	/* through comp_work, like a full batch, so there is only one
+	 * retirement path to cancel
+	 */
+	task = list_last_entry(&ucx_hndl->in_flight_list, struct xio_task,
+			       tasks_list_entry);
+	ucx_task = (struct xio_ucx_task *)task->dd_data;
+	if (xio_ctx_add_work(ucx_hndl->base.ctx, task,
+			     xio_ucx_tx_completion_handler,
+			     &ucx_task->comp_work))
+		ERROR_LOG("xio_ctx_add_work failed.\n");
+}
+
+/*---------------------------------------------------------------------------*/
+/* xio_ucx_tx_comp_now							     */
+/*---------------------------------------------------------------------------*/
+static void xio_ucx_tx_comp_now(struct xio_ucx_transport *ucx_hndl)
+{
+	struct xio_task		*ptask;
+
+	/* retiring inline makes any retirement already scheduled stale -
+	 * left alone it would run later against newer in flight tasks
+	 */
+	xio_ctx_del_delayed_work(ucx_hndl->base.ctx,
+				 &ucx_hndl->comp_deadline_work);
+	list_for_each_entry(ptask, &ucx_hndl->in_flight_list,
+			    tasks_list_entry) {
+		XIO_TO_UCX_TASK(ptask, ucx_task);
+
+		xio_ctx_del_work(ucx_hndl->base.ctx, &ucx_task->comp_work);
+	}
+
+	xio_ucx_tx_completion_handler(
+			list_last_entry(&ucx_hndl->in_flight_list,
+					struct xio_task, tasks_list_entry));
+}
+
 /*---------------------------------------------------------------------------*/
 /* xio_ucx_disconnect_helper						     */
 /*---------------------------------------------------------------------------*/
@@ -945,6 +1192,193 @@ static int xio_ucx_write_sn(struct xio_task *task, uint16_t sn)
 	return 0;
 }
 
+/*---------------------------------------------------------------------------*/
+/* xio_ucx_tx_is_prio							     */
+/*---------------------------------------------------------------------------*/
+static inline int xio_ucx_tx_is_prio(struct xio_task *task)
+{
+	/* only cancels - other control frames (setup, session and
+	 * connection teardown) rely on arriving in submission order
+	 */
+	return IS_CANCEL(task->tlv_type);
+}
+
+/*---------------------------------------------------------------------------*/
+/* xio_ucx_tx_credit_ok							     */
+/*---------------------------------------------------------------------------*/
+static inline int xio_ucx_tx_credit_ok(struct xio_ucx_transport *ucx_hndl,
+				       struct xio_task *task)
+{
+	XIO_TO_UCX_TASK(task, ucx_task);
+
+	/* only requests land in the peer's receive pool until answered */
+	return !ucx_hndl->peer_rx_credits ||
+	       task->tlv_type != XIO_MSG_REQ ||
+	       ucx_task->tx_credit_held ||
+	       ucx_hndl->tx_credits > 0;
+}
+
+/*---------------------------------------------------------------------------*/
+/* xio_ucx_tx_start							     */
+/*---------------------------------------------------------------------------*/
+static void xio_ucx_tx_start(struct xio_ucx_transport *ucx_hndl,
+			     struct xio_task *task)
+{
+	XIO_TO_UCX_TASK(task, ucx_task);
+
+	if (ucx_hndl->peer_rx_credits &&
+	    task->tlv_type == XIO_MSG_REQ &&
+	    !ucx_task->tx_credit_held) {
+		ucx_hndl->tx_credits--;
+		ucx_task->tx_credit_held = 1;
+	}
+	/* bulk made progress - priority may overtake again */
+	if (!xio_ucx_tx_is_prio(task))
+		ucx_hndl->tx_prio_run = 0;
+	xio_ucx_write_sn(task, ucx_hndl->sn);
+	ucx_task->sn = ucx_hndl->sn;
+	ucx_hndl->sn_index[ucx_task->sn & ucx_hndl->sn_index_mask] = task;
+	ucx_hndl->sn++;
+	ucx_task->txd.stage = XIO_UCX_TX_IN_SEND_CTL;
+}
+
+/*---------------------------------------------------------------------------*/
+/* xio_ucx_tx_credit_return						     */
+/*---------------------------------------------------------------------------*/
+static void xio_ucx_tx_credit_return(struct xio_ucx_transport *ucx_hndl,
+				     struct xio_task *task)
+{
+	struct xio_task		*ptask;
+	struct xio_ucx_task	*pucx_task;
+
+	if (!ucx_hndl->peer_rx_credits || task->tlv_type != XIO_MSG_REQ)
+		return;
+
+	ptask = list_first_entry_or_null(&ucx_hndl->tx_credit_list,
+					 struct xio_task, tasks_list_entry);
+	if (!ptask) {
+		ucx_hndl->tx_credits++;
+		return;
+	}
+
+	/* hand the credit straight to the oldest parked request so
+	 * newer requests cannot overtake it
+	 */
+	pucx_task = (struct xio_ucx_task *)ptask->dd_data;
+	pucx_task->tx_credit_parked = 0;
+	pucx_task->tx_credit_held = 1;
+	list_move_tail(&ptask->tasks_list_entry, &ucx_hndl->tx_ready_list);
+	ucx_hndl->tx_ready_tasks_num++;
+}
+
+/*---------------------------------------------------------------------------*/
+/* xio_ucx_tx_batch_tune						     */
+/*---------------------------------------------------------------------------*/
+static void xio_ucx_tx_batch_tune(struct xio_ucx_transport *ucx_hndl,
+				  cycles_t elapsed, int blocked)
+{
+	cycles_t target = (cycles_t)(ucx_options.ucx_batch_lat_usec * g_mhz);
+
+	if (blocked || elapsed > target) {
+		/* socket full or over the latency target - gather less */
+		if (ucx_hndl->tx_batch == 1 && ucx_hndl->comp_batch == 1)
+			return;
+		ucx_hndl->tx_batch = max(ucx_hndl->tx_batch / 2, 1);
+		ucx_hndl->comp_batch = max(ucx_hndl->comp_batch / 2, 1);
+		__sync_fetch_and_add(&ucx_batch_shrink_cnt, 1);
+	} else if (ucx_hndl->tx_ready_tasks_num) {
+		/* time to spare yet work left behind - the batch limited us */
+		if (ucx_hndl->tx_batch == TX_BATCH &&
+		    ucx_hndl->comp_batch == COMPLETION_BATCH_MAX)
+			return;
+		ucx_hndl->tx_batch = min(ucx_hndl->tx_batch + 1, TX_BATCH);
+		ucx_hndl->comp_batch = min(ucx_hndl->comp_batch + 1,
+					   COMPLETION_BATCH_MAX);
+		__sync_fetch_and_add(&ucx_batch_grow_cnt, 1);
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+/* xio_ucx_send_mt							     */
+/*---------------------------------------------------------------------------*/
+int xio_ucx_send_mt(struct xio_transport_base *transport,
+		    struct xio_task *task)
+{
+	struct xio_ucx_transport *ucx_hndl =
+		(struct xio_ucx_transport *)transport;
+	XIO_TO_UCX_TASK(task, ucx_task);
+	struct xio_ucx_task	*head;
+
+	/* the closer waits for mpsc_users to drop to zero before it takes
+	 * the stack for the last time and closes mpsc_efd
+	 */
+	__sync_fetch_and_add(&ucx_hndl->mpsc_users, 1);
+	if (ucx_hndl->mpsc_closing ||
+	    ucx_hndl->state >= XIO_TRANSPORT_STATE_DISCONNECTED) {
+		__sync_fetch_and_sub(&ucx_hndl->mpsc_users, 1);
+		xio_set_error(XIO_E_STATE);
+		return -1;
+	}
+
+	/* callable from any thread: push onto the submission stack, the
+	 * context thread preps and sends it
+	 */
+	do {
+		head = ucx_hndl->mpsc_head;
+		ucx_task->mpsc_next = head;
+	} while (!__sync_bool_compare_and_swap(&ucx_hndl->mpsc_head,
+					       head, ucx_task));
+
+	/* one wakeup per drain - the handler clears the flag before it
+	 * takes the stack, so a push it misses always signals again
+	 */
+	if (!__sync_lock_test_and_set(&ucx_hndl->mpsc_signaled, 1))
+		eventfd_write(ucx_hndl->mpsc_efd, 1);
+
+	__sync_fetch_and_sub(&ucx_hndl->mpsc_users, 1);
+
+	return 0;
+}
+
+/*---------------------------------------------------------------------------*/
+/* xio_ucx_mpsc_drain							     */
+/*---------------------------------------------------------------------------*/
+static void xio_ucx_mpsc_drain(struct xio_ucx_transport *ucx_hndl)
+{
+	union xio_transport_event_data	event_data;
+	struct xio_ucx_task		*ucx_task, *next, *fifo = NULL;
+	int				batching;
+
+	ucx_task = __sync_lock_test_and_set(&ucx_hndl->mpsc_head, NULL);
+	if (!ucx_task)
+		return;
+
+	/* producers push LIFO - restore submission order */
+	while (ucx_task) {
+		next = ucx_task->mpsc_next;
+		ucx_task->mpsc_next = fifo;
+		fifo = ucx_task;
+		ucx_task = next;
+	}
+
+	batching = ucx_hndl->tx_batching;
+	ucx_hndl->tx_batching = 1;
+	for (ucx_task = fifo; ucx_task; ucx_task = next) {
+		next = ucx_task->mpsc_next;
+		if (xio_ucx_send(&ucx_hndl->base, ucx_task->task) == 0)
+			continue;
+
+		ERROR_LOG("queued send failed. %s\n", xio_strerror(xio_errno()));
+		event_data.msg_error.reason	= (enum xio_status)xio_errno();
+		event_data.msg_error.direction	= XIO_MSG_DIRECTION_OUT;
+		event_data.msg_error.task	= ucx_task->task;
+		xio_transport_notify_observer(&ucx_hndl->base,
+					      XIO_TRANSPORT_EVENT_MESSAGE_ERROR,
+					      &event_data);
+	}
+	ucx_hndl->tx_batching = batching;
+}
+
 /*---------------------------------------------------------------------------*/
 /* xio_ucx_xmit								     */
 /*---------------------------------------------------------------------------*/
@@ -955,24 +1389,51 @@ int xio_ucx_xmit(struct xio_ucx_transport *ucx_hndl)
 	struct xio_ucx_task	*ucx_task = NULL, *next_ucx_task = NULL;
 	int			retval = 0, retval2 = 0;
 	int			imm_comp = 0;
-	int			batch_nr = TX_BATCH, batch_count = 0, tmp_count;
+	int			batch_nr = ucx_hndl->tx_batch;
+	int			batch_count = 0, tmp_count;
 	unsigned int		i;
 	unsigned int		iov_len;
 	uint64_t		bytes_sent;
+	uint64_t		pass_bytes = 0;
+	uint64_t		pass_left = 0;
+	int			yield = 0;
+	cycles_t		start = 0;
+
+	/* cross-thread submissions join this pass */
+	if (ucx_hndl->mpsc_head)
+		xio_ucx_mpsc_drain(ucx_hndl);
+
+	/* a setup message the socket did not take whole goes first */
+	if (ucx_hndl->tx_setup_task) {
+		if (xio_ucx_send_setup_work(ucx_hndl,
+					    ucx_hndl->tx_setup_task) < 0)
+			return -1;
+		if (ucx_hndl->tx_setup_task) {
+			xio_set_error(XIO_EAGAIN);
+			return -1;
+		}
+	}
+
+	/* whatever was held back goes out now */
+	ucx_hndl->tx_held_nr = 0;
+	ucx_hndl->tx_held_bytes = 0;
 
 	if (ucx_hndl->tx_ready_tasks_num == 0 ||
-	    ucx_hndl->tx_comp_cnt > COMPLETION_BATCH_MAX ||
+	    ucx_hndl->tx_comp_cnt > ucx_hndl->comp_batch ||
 	    ucx_hndl->state != XIO_TRANSPORT_STATE_CONNECTED) {
 		xio_set_error(XIO_EAGAIN);
 		return -1;
 	}
 
+	if (ucx_options.ucx_batch_lat_usec)
+		start = get_cycles();
+
 	task = list_first_entry(&ucx_hndl->tx_ready_list, struct xio_task,
 				tasks_list_entry);
 
 	/* if "ready to send queue" is not empty */
 	while (likely(ucx_hndl->tx_ready_tasks_num &&
-		      (ucx_hndl->tx_comp_cnt < COMPLETION_BATCH_MAX))) {
+		      (ucx_hndl->tx_comp_cnt < ucx_hndl->comp_batch))) {
 		next_task = list_first_entry_or_null(&task->tasks_list_entry,
 						     struct xio_task,
 						     tasks_list_entry);
@@ -983,10 +1444,23 @@ int xio_ucx_xmit(struct xio_ucx_transport *ucx_hndl)
 
 		switch (ucx_task->txd.stage) {
 		case XIO_UCX_TX_BEFORE:
-			xio_ucx_write_sn(task, ucx_hndl->sn);
-			ucx_task->sn = ucx_hndl->sn;
-			ucx_hndl->sn++;
-			ucx_task->txd.stage = XIO_UCX_TX_IN_SEND_CTL;
+			if (!xio_ucx_tx_credit_ok(ucx_hndl, task)) {
+				/* park it - responses, cancels and control
+				 * frames behind it must keep flowing or two
+				 * credit-starved peers deadlock
+				 */
+				ucx_task->tx_credit_parked = 1;
+				list_move_tail(&task->tasks_list_entry,
+					       &ucx_hndl->tx_credit_list);
+				ucx_hndl->tx_ready_tasks_num--;
+				if (ucx_hndl->tx_ready_tasks_num)
+					task = list_first_entry(
+						&ucx_hndl->tx_ready_list,
+						struct xio_task,
+						tasks_list_entry);
+				break;
+			}
+			xio_ucx_tx_start(ucx_hndl, task);
 			/*fallthrough*/
 		case XIO_UCX_TX_IN_SEND_CTL:
 			/* for single socket, ctl_msg_len is zero */
@@ -1008,7 +1482,9 @@ int xio_ucx_xmit(struct xio_ucx_transport *ucx_hndl)
 			    batch_count != ucx_hndl->tx_ready_tasks_num &&
 			    next_task &&
 			    next_ucx_task->txd.stage
-			    <= XIO_UCX_TX_IN_SEND_CTL) {
+			    <= XIO_UCX_TX_IN_SEND_CTL &&
+			    (next_ucx_task->txd.stage != XIO_UCX_TX_BEFORE ||
+			     xio_ucx_tx_credit_ok(ucx_hndl, next_task))) {
 				task = next_task;
 				break;
 			}
@@ -1018,8 +1494,10 @@ int xio_ucx_xmit(struct xio_ucx_transport *ucx_hndl)
 			ucx_hndl->tmp_work.msg.msg_iovlen =
 					ucx_hndl->tmp_work.msg_len;
 
-			retval = xio_ucx_sendmsg_work(ucx_hndl->tcp_sock.cfd,
-						      &ucx_hndl->tmp_work, 0);
+			retval = xio_ucx_sendmsg_work(ucx_hndl,
+						      ucx_hndl->tcp_sock.cfd,
+						      &ucx_hndl->tmp_work,
+						      0, 0);
 
 			task = list_first_entry(&ucx_hndl->tx_ready_list,
 						struct xio_task,
@@ -1062,14 +1540,8 @@ int xio_ucx_xmit(struct xio_ucx_transport *ucx_hndl)
 				if (xio_get_last_socket_error() != XIO_EAGAIN)
 					return -1;
 
-				/* for eagain, add event for ready for write*/
-				retval = xio_context_modify_ev_handler(
-						ucx_hndl->base.ctx,
-						ucx_hndl->tcp_sock.cfd,
-						XIO_POLLIN | XIO_POLLRDHUP |
-						XIO_POLLOUT);
-				if (retval != 0)
-					ERROR_LOG("modify events failed.\n");
+				/* for eagain, wait for ready for write */
+				xio_ucx_set_tx_blocked(ucx_hndl);
 
 				retval = -1;
 				goto handle_completions;
@@ -1098,12 +1570,24 @@ int xio_ucx_xmit(struct xio_ucx_transport *ucx_hndl)
 			if (batch_count != batch_nr &&
 			    batch_count != ucx_hndl->tx_ready_tasks_num &&
 			    next_task &&
-			    (next_ucx_task->txd.stage ==
-			    XIO_UCX_TX_IN_SEND_DATA) &&
 			    (next_ucx_task->txd.msg.msg_iovlen +
 			    ucx_hndl->tmp_work.msg_len) < IOV_MAX) {
-				task = next_task;
-				break;
+				/* messages queued behind this one that have
+				 * not started yet join the same sendmsg
+				 */
+				if (next_ucx_task->txd.stage ==
+				    XIO_UCX_TX_BEFORE &&
+				    next_ucx_task->txd.ctl_msg_len == 0 &&
+				    xio_ucx_tx_credit_ok(ucx_hndl, next_task)) {
+					xio_ucx_tx_start(ucx_hndl, next_task);
+					next_ucx_task->txd.stage =
+						XIO_UCX_TX_IN_SEND_DATA;
+				}
+				if (next_ucx_task->txd.stage ==
+				    XIO_UCX_TX_IN_SEND_DATA) {
+					task = next_task;
+					break;
+				}
 			}
 
 			ucx_hndl->tmp_work.msg.msg_iov =
@@ -1111,10 +1595,21 @@ int xio_ucx_xmit(struct xio_ucx_transport *ucx_hndl)
 			ucx_hndl->tmp_work.msg.msg_iovlen =
 					ucx_hndl->tmp_work.msg_len;
 
+			/* stop at the pass budget even mid message; the rest
+			 * stays queued and goes out on the next pass
+			 */
+			if (ucx_options.ucx_tx_pass_bytes)
+				pass_left = (uint64_t)
+					ucx_options.ucx_tx_pass_bytes -
+					pass_bytes;
+
 			bytes_sent = ucx_hndl->tmp_work.tot_iov_byte_len;
-			retval = xio_ucx_sendmsg_work(ucx_hndl->tcp_sock.cfd,
-						      &ucx_hndl->tmp_work, 0);
+			retval = xio_ucx_sendmsg_work(ucx_hndl,
+						      ucx_hndl->tcp_sock.cfd,
+						      &ucx_hndl->tmp_work, 0,
+						      pass_left);
 			bytes_sent -= ucx_hndl->tmp_work.tot_iov_byte_len;
+			pass_bytes += bytes_sent;
 
 			task = list_first_entry(&ucx_hndl->tx_ready_list,
 						struct xio_task,
@@ -1183,19 +1678,24 @@ int xio_ucx_xmit(struct xio_ucx_transport *ucx_hndl)
 				if (xio_get_last_socket_error() != XIO_EAGAIN)
 					return -1;
 
-				/* for eagain, add event for ready for write*/
-				retval = xio_context_modify_ev_handler(
-						ucx_hndl->base.ctx,
-						ucx_hndl->tcp_sock.cfd,
-						XIO_POLLIN | XIO_POLLRDHUP |
-						XIO_POLLOUT);
-				if (retval != 0)
-					ERROR_LOG("modify events failed.\n");
+				/* for eagain, wait for ready for write */
+				xio_ucx_set_tx_blocked(ucx_hndl);
 
 				retval = -1;
 				goto handle_completions;
 			}
 
+			/* a big payload may not hog the loop - finish it on
+			 * the next round and let rx and other fds run first
+			 */
+			if (ucx_options.ucx_tx_pass_bytes &&
+			    pass_bytes >=
+				(uint64_t)ucx_options.ucx_tx_pass_bytes &&
+			    ucx_hndl->tx_ready_tasks_num) {
+				yield = 1;
+				goto handle_completions;
+			}
+
 			task = list_first_entry(&ucx_hndl->tx_ready_list,
 						struct xio_task,
 						tasks_list_entry);
@@ -1209,8 +1709,15 @@ int xio_ucx_xmit(struct xio_ucx_transport *ucx_hndl)
 
 handle_completions:
 
+	/* tune before the check below so a shrunk completion batch is
+	 * honoured right away instead of stalling the next xmit
+	 */
+	if (ucx_options.ucx_batch_lat_usec)
+		xio_ucx_tx_batch_tune(ucx_hndl, get_cycles() - start,
+				      retval < 0);
+
 	if (task_success &&
-	    (ucx_hndl->tx_comp_cnt >= COMPLETION_BATCH_MAX ||
+	    (ucx_hndl->tx_comp_cnt >= ucx_hndl->comp_batch ||
 	     imm_comp)) {
 		ucx_task = (struct xio_ucx_task *)task_success->dd_data;
 		retval2 = xio_ctx_add_work(ucx_hndl->base.ctx,
@@ -1221,12 +1728,117 @@ handle_completions:
 			ERROR_LOG("xio_ctx_add_work failed.\n");
 			return retval2;
 		}
+		xio_ctx_del_delayed_work(ucx_hndl->base.ctx,
+					 &ucx_hndl->comp_deadline_work);
+	} else if (task_success && ucx_options.ucx_comp_deadline_msec &&
+		   !xio_is_delayed_work_pending(
+				&ucx_hndl->comp_deadline_work)) {
+		/* light traffic - bound how long the partial batch waits */
+		retval2 = xio_ctx_add_delayed_work(
+				ucx_hndl->base.ctx,
+				ucx_options.ucx_comp_deadline_msec,
+				ucx_hndl, xio_ucx_tx_comp_deadline,
+				&ucx_hndl->comp_deadline_work);
+		if (retval2 != 0)
+			ERROR_LOG("xio_ctx_add_delayed_work failed.\n");
 	}
 	xio_context_disable_event(&ucx_hndl->flush_tx_event);
+	if (yield)
+		xio_context_add_event(ucx_hndl->base.ctx,
+				      &ucx_hndl->flush_tx_event);
+
+	if (!ucx_hndl->tx_ready_tasks_num)
+		xio_ucx_sockbuf_tune(ucx_hndl, SO_SNDBUF, 0);
 
 	return retval < 0 ? retval : 0;
 }
 
+/*---------------------------------------------------------------------------*/
+/* xio_ucx_tx_enqueue							     */
+/*---------------------------------------------------------------------------*/
+static void xio_ucx_tx_enqueue(struct xio_ucx_transport *ucx_hndl,
+			       struct xio_task *task)
+{
+	struct list_head	*pos = ucx_hndl->tx_ready_list.prev;
+	struct xio_task		*ptask;
+	struct xio_ucx_task	*pucx_task;
+
+	/* cancel frames jump over bulk messages that have not started
+	 * yet; up to ucx_tx_prio_weight of them per bulk message, so bulk
+	 * cannot be starved
+	 */
+	if (xio_ucx_tx_is_prio(task) &&
+	    ucx_hndl->tx_prio_run < ucx_options.ucx_tx_prio_weight) {
+		while (pos != &ucx_hndl->tx_ready_list) {
+			ptask = list_entry(pos, struct xio_task,
+					   tasks_list_entry);
+			pucx_task = (struct xio_ucx_task *)ptask->dd_data;
+			if (pucx_task->txd.stage != XIO_UCX_TX_BEFORE ||
+			    xio_ucx_tx_is_prio(ptask))
+				break;
+			pos = pos->prev;
+		}
+		if (pos != ucx_hndl->tx_ready_list.prev)
+			ucx_hndl->tx_prio_run++;
+	}
+
+	list_move(&task->tasks_list_entry, pos);
+	ucx_hndl->tx_ready_tasks_num++;
+}
+
+/*---------------------------------------------------------------------------*/
+/* xio_ucx_tx_flush							     */
+/*---------------------------------------------------------------------------*/
+static int xio_ucx_tx_flush(struct xio_ucx_transport *ucx_hndl)
+{
+	int retval;
+
+	retval = xio_ucx_xmit(ucx_hndl);
+	if (retval) {
+		/* no need xio_get_last_error here */
+		retval = xio_errno();
+		if (retval != XIO_EAGAIN) {
+			ERROR_LOG("xio_xmit_ucx failed. %s\n",
+				  xio_strerror(retval));
+			return -1;
+		}
+		xio_context_add_event(ucx_hndl->base.ctx,
+				      &ucx_hndl->flush_tx_event);
+		retval = 0;
+	}
+
+	return retval;
+}
+
+/*---------------------------------------------------------------------------*/
+/* xio_ucx_tx_kick							     */
+/*---------------------------------------------------------------------------*/
+static int xio_ucx_tx_kick(struct xio_ucx_transport *ucx_hndl,
+			   struct xio_task *task, size_t tlv_len)
+{
+	/* xio_ucx_send_batch flushes once after the last task */
+	if (ucx_hndl->tx_batching)
+		return 0;
+
+	/* coalescing: below both thresholds the send waits for
+	 * flush_tx_event, i.e. the end of this event loop round
+	 */
+	if (ucx_options.ucx_coalesce_msgs && !task->is_control) {
+		ucx_hndl->tx_held_nr++;
+		ucx_hndl->tx_held_bytes += tlv_len;
+		if (ucx_hndl->tx_held_nr < ucx_options.ucx_coalesce_msgs &&
+		    (!ucx_options.ucx_coalesce_bytes ||
+		     ucx_hndl->tx_held_bytes <
+				(size_t)ucx_options.ucx_coalesce_bytes)) {
+			xio_context_add_event(ucx_hndl->base.ctx,
+					      &ucx_hndl->flush_tx_event);
+			return 0;
+		}
+	}
+
+	return xio_ucx_tx_flush(ucx_hndl);
+}
+
 /*---------------------------------------------------------------------------*/
 /* xio_ucx_prep_req_in_data						     */
 /*---------------------------------------------------------------------------*/
@@ -1390,9 +2002,56 @@ size_t xio_ucx_dual_sock_set_txd(struct xio_task *task)
 		ucx_task->txd.msg.msg_iov = ucx_task->txd.msg_iov;
 	}
 
-	ucx_task->txd.msg.msg_iovlen = ucx_task->txd.msg_len;
-
-	return ucx_task->txd.ctl_msg_len - XIO_TLV_LEN;
+	ucx_task->txd.msg.msg_iovlen = ucx_task->txd.msg_len;
+
+	return ucx_task->txd.ctl_msg_len - XIO_TLV_LEN;
+}
+
+/*---------------------------------------------------------------------------*/
+/* xio_ucx_cancel_hash_bucket						     */
+/*---------------------------------------------------------------------------*/
+static inline struct list_head *xio_ucx_cancel_hash_bucket(
+		struct xio_ucx_transport *ucx_hndl,
+		uint64_t sn, uint64_t stag)
+{
+	uint64_t key = (sn ^ (stag * 0x9e3779b97f4a7c15ULL));
+
+	return &ucx_hndl->cancel_hash[(key ^ (key >> 32)) &
+				      ucx_hndl->cancel_hash_mask];
+}
+
+/*---------------------------------------------------------------------------*/
+/* xio_ucx_cancel_hash_add						     */
+/*---------------------------------------------------------------------------*/
+static inline void xio_ucx_cancel_hash_add(struct xio_ucx_transport *ucx_hndl,
+					   struct xio_task *task)
+{
+	XIO_TO_UCX_TASK(task, ucx_task);
+
+	list_add_tail(&ucx_task->cancel_list_entry,
+		      xio_ucx_cancel_hash_bucket(ucx_hndl, task->omsg->sn,
+						 task->stag));
+}
+
+/*---------------------------------------------------------------------------*/
+/* xio_ucx_cancel_hash_lookup						     */
+/*---------------------------------------------------------------------------*/
+static struct xio_task *xio_ucx_cancel_hash_lookup(
+		struct xio_ucx_transport *ucx_hndl,
+		uint64_t sn, uint64_t stag)
+{
+	struct xio_ucx_task	*ucx_task;
+	struct list_head	*bucket;
+
+	bucket = xio_ucx_cancel_hash_bucket(ucx_hndl, sn, stag);
+	list_for_each_entry(ucx_task, bucket, cancel_list_entry) {
+		if (ucx_task->task->omsg &&
+		    ucx_task->task->omsg->sn == sn &&
+		    ucx_task->task->stag == stag)
+			return ucx_task->task;
+	}
+
+	return NULL;
 }
 
 /*---------------------------------------------------------------------------*/
@@ -1433,22 +2092,12 @@ static int xio_ucx_send_req(struct xio_ucx_transport *ucx_hndl,
 
 	ucx_task->out_ucx_op = XIO_UCX_SEND;
 
-	list_move_tail(&task->tasks_list_entry, &ucx_hndl->tx_ready_list);
+	if (task->omsg)
+		xio_ucx_cancel_hash_add(ucx_hndl, task);
 
-	ucx_hndl->tx_ready_tasks_num++;
-
-	retval = xio_ucx_xmit(ucx_hndl);
-	if (retval) {
-		if (xio_errno() != XIO_EAGAIN) {
-			DEBUG_LOG("xio_ucx_xmit failed\n");
-			return -1;
-		}
-		xio_context_add_event(ucx_hndl->base.ctx,
-				      &ucx_hndl->flush_tx_event);
-		retval = 0;
-	}
+	xio_ucx_tx_enqueue(ucx_hndl, task);
 
-	return retval;
+	return xio_ucx_tx_kick(ucx_hndl, task, tlv_len);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -1541,13 +2190,19 @@ static int xio_ucx_prep_rsp_header(struct xio_ucx_transport *ucx_hndl,
 
 	ucx_task->txd.ctl_msg_len = xio_mbuf_tlv_len(&task->mbuf);
 
-	/* write the payload header */
+	/* write the payload header - a NULL base only reserves the room,
+	 * the caller serializes into the mbuf itself
+	 */
 	if (ulp_hdr_len) {
-		if (xio_mbuf_write_array(
-		    &task->mbuf,
-		    task->omsg->out.header.iov_base,
-		    task->omsg->out.header.iov_len) != 0)
+		if (!task->omsg->out.header.iov_base) {
+			if (xio_mbuf_inc(&task->mbuf, ulp_hdr_len) != 0)
+				goto cleanup;
+		} else if (xio_mbuf_write_array(
+			   &task->mbuf,
+			   task->omsg->out.header.iov_base,
+			   task->omsg->out.header.iov_len) != 0) {
 			goto cleanup;
+		}
 	}
 
 	/* write the pad between header and data */
@@ -1775,25 +2430,9 @@ static int xio_ucx_send_rsp(struct xio_ucx_transport *ucx_hndl,
 	if (xio_mbuf_write_tlv(&task->mbuf, task->tlv_type, tlv_len) != 0)
 		goto cleanup;
 
-	list_move_tail(&task->tasks_list_entry, &ucx_hndl->tx_ready_list);
-
-	ucx_hndl->tx_ready_tasks_num++;
-
-	retval = xio_ucx_xmit(ucx_hndl);
-	if (retval) {
-		/* no need xio_get_last_error here */
-		retval = xio_errno();
-		if (retval != XIO_EAGAIN) {
-			ERROR_LOG("xio_xmit_ucx failed. %s\n",
-					xio_strerror(retval));
-			return -1;
-		}
-		xio_context_add_event(ucx_hndl->base.ctx,
-				      &ucx_hndl->flush_tx_event);
-		retval = 0;
-	}
+	xio_ucx_tx_enqueue(ucx_hndl, task);
 
-	return retval;
+	return xio_ucx_tx_kick(ucx_hndl, task, tlv_len);
 
 cleanup:
 	xio_set_error(XIO_E_MSG_SIZE);
@@ -2405,6 +3044,28 @@ cleanup:
 	return -1;
 }
 
+/*---------------------------------------------------------------------------*/
+/* xio_ucx_notify_msg							     */
+/*---------------------------------------------------------------------------*/
+static void xio_ucx_notify_msg(struct xio_ucx_transport *ucx_hndl,
+			       struct xio_task *task)
+{
+	union xio_transport_event_data event_data;
+
+	list_move_tail(&task->tasks_list_entry, &ucx_hndl->io_list);
+
+	if (xio_ucx_wc_capture(ucx_hndl, task, XIO_WC_OP_RECV))
+		return;
+
+	/* fill notification event */
+	event_data.msg.op	= XIO_WC_OP_RECV;
+	event_data.msg.task	= task;
+
+	xio_transport_notify_observer(&ucx_hndl->base,
+				      XIO_TRANSPORT_EVENT_NEW_MESSAGE,
+				      &event_data);
+}
+
 /*---------------------------------------------------------------------------*/
 /* xio_ucx_on_recv_req_data						     */
 /*---------------------------------------------------------------------------*/
@@ -2412,7 +3073,6 @@ static int xio_ucx_on_recv_req_data(struct xio_ucx_transport *ucx_hndl,
 				    struct xio_task *task)
 {
 	XIO_TO_UCX_TASK(task, ucx_task);
-	union xio_transport_event_data event_data;
 
 	switch (ucx_task->out_ucx_op) {
 	case XIO_UCX_SEND:
@@ -2426,15 +3086,7 @@ static int xio_ucx_on_recv_req_data(struct xio_ucx_transport *ucx_hndl,
 		break;
 	};
 
-	/* fill notification event */
-	event_data.msg.op	= XIO_WC_OP_RECV;
-	event_data.msg.task	= task;
-
-	list_move_tail(&task->tasks_list_entry, &ucx_hndl->io_list);
-
-	xio_transport_notify_observer(&ucx_hndl->base,
-				      XIO_TRANSPORT_EVENT_NEW_MESSAGE,
-				      &event_data);
+	xio_ucx_notify_msg(ucx_hndl, task);
 
 	return 0;
 }
@@ -2474,6 +3126,7 @@ static int xio_ucx_on_recv_rsp_header(struct xio_ucx_transport *ucx_hndl,
 
 	/* mark the sender task as arrived */
 	task->sender_task->state = XIO_TASK_STATE_RESPONSE_RECV;
+	xio_ucx_tx_credit_return(ucx_hndl, task->sender_task);
 
 	imsg		= &task->imsg;
 	isgtbl		= xio_sg_table_get(&imsg->in);
@@ -2578,7 +3231,6 @@ static int xio_ucx_on_recv_rsp_data(struct xio_ucx_transport *ucx_hndl,
 				    struct xio_task *task)
 {
 	XIO_TO_UCX_TASK(task, ucx_task);
-	union xio_transport_event_data event_data;
 	struct xio_msg		*imsg;
 	struct xio_msg		*omsg;
 	unsigned int		i;
@@ -2705,16 +3357,8 @@ static int xio_ucx_on_recv_rsp_data(struct xio_ucx_transport *ucx_hndl,
 
 partial_msg:
 
-	/* fill notification event */
-	event_data.msg.op	= XIO_WC_OP_RECV;
-	event_data.msg.task	= task;
-
-	list_move_tail(&task->tasks_list_entry, &ucx_hndl->io_list);
-
 	/* notify the upper layer of received message */
-	xio_transport_notify_observer(&ucx_hndl->base,
-				      XIO_TRANSPORT_EVENT_NEW_MESSAGE,
-				      &event_data);
+	xio_ucx_notify_msg(ucx_hndl, task);
 	return 0;
 }
 
@@ -2739,6 +3383,41 @@ static int xio_ucx_cancel_req_handler(struct xio_ucx_transport *ucx_hndl,
 	return 0;
 }
 
+/*---------------------------------------------------------------------------*/
+/* xio_ucx_sn_lookup							     */
+/*---------------------------------------------------------------------------*/
+static struct xio_task *xio_ucx_sn_lookup(struct xio_ucx_transport *ucx_hndl,
+					  uint16_t sn)
+{
+	struct xio_task		*ptask;
+	struct xio_ucx_task	*ucx_task;
+
+	ptask = ucx_hndl->sn_index[sn & ucx_hndl->sn_index_mask];
+	if (ptask) {
+		ucx_task = (struct xio_ucx_task *)ptask->dd_data;
+		if (ucx_task->sn == sn)
+			return ptask;
+	}
+
+	/* slot was reused by a newer send - more than the queue depth
+	 * is outstanding, fall back to the lists
+	 */
+	list_for_each_entry(ptask, &ucx_hndl->in_flight_list,
+			    tasks_list_entry) {
+		ucx_task = (struct xio_ucx_task *)ptask->dd_data;
+		if (ucx_task->sn == sn)
+			return ptask;
+	}
+	list_for_each_entry(ptask, &ucx_hndl->tx_comp_list,
+			    tasks_list_entry) {
+		ucx_task = (struct xio_ucx_task *)ptask->dd_data;
+		if (ucx_task->sn == sn)
+			return ptask;
+	}
+
+	return NULL;
+}
+
 /*---------------------------------------------------------------------------*/
 /* xio_ucx_cancel_rsp_handler						     */
 /*---------------------------------------------------------------------------*/
@@ -2747,36 +3426,11 @@ static int xio_ucx_cancel_rsp_handler(struct xio_ucx_transport *ucx_hndl,
 				      void *ulp_msg, size_t ulp_msg_sz)
 {
 	union xio_transport_event_data	event_data;
-	struct xio_task			*ptask, *next_ptask;
-	struct xio_ucx_task		*ucx_task;
 	struct xio_task			*task_to_cancel = NULL;
 
 	if ((cancel_hdr->result ==  XIO_E_MSG_CANCELED) ||
 	    (cancel_hdr->result ==  XIO_E_MSG_CANCEL_FAILED)) {
-		/* look in the in_flight */
-		list_for_each_entry_safe(ptask, next_ptask,
-					 &ucx_hndl->in_flight_list,
-				tasks_list_entry) {
-			ucx_task = (struct xio_ucx_task *)ptask->dd_data;
-			if (ucx_task->sn == cancel_hdr->sn) {
-				task_to_cancel = ptask;
-				break;
-			}
-		}
-		if (!task_to_cancel) {
-			/* look in the tx_comp */
-			list_for_each_entry_safe(ptask, next_ptask,
-						 &ucx_hndl->tx_comp_list,
-					tasks_list_entry) {
-				ucx_task = (struct xio_ucx_task *)
-						ptask->dd_data;
-				if (ucx_task->sn == cancel_hdr->sn) {
-					task_to_cancel = ptask;
-					break;
-				}
-			}
-		}
-
+		task_to_cancel = xio_ucx_sn_lookup(ucx_hndl, cancel_hdr->sn);
 		if (!task_to_cancel)  {
 			ERROR_LOG("[%u] - Failed to found canceled message\n",
 				  cancel_hdr->sn);
@@ -2792,6 +3446,9 @@ static int xio_ucx_cancel_rsp_handler(struct xio_ucx_transport *ucx_hndl,
 					&event_data);
 			return 0;
 		}
+		/* a request dropped by the peer frees its slot too */
+		if (cancel_hdr->result == XIO_E_MSG_CANCELED)
+			xio_ucx_tx_credit_return(ucx_hndl, task_to_cancel);
 	}
 
 	/* fill notification event */
@@ -2975,7 +3632,8 @@ cleanup:
 static int xio_ucx_send_cancel(struct xio_ucx_transport *ucx_hndl,
 			       uint32_t tlv_type,
 			       struct  xio_ucx_cancel_hdr *cancel_hdr,
-			       void *ulp_msg, size_t ulp_msg_sz)
+			       void *ulp_msg, size_t ulp_msg_sz,
+			       int flush)
 {
 	uint64_t		tlv_len;
 	uint16_t		ulp_hdr_len;
@@ -3002,25 +3660,9 @@ static int xio_ucx_send_cancel(struct xio_ucx_transport *ucx_hndl,
 	ucx_task->read_num_reg_mem		= 0;
 
 	ulp_hdr_len = sizeof(*cancel_hdr) + sizeof(uint16_t) + ulp_msg_sz;
-	ucx_hndl->dummy_msg.out.header.iov_base = ucalloc(1, ulp_hdr_len);
+	ucx_hndl->dummy_msg.out.header.iov_base = NULL;
 	ucx_hndl->dummy_msg.out.header.iov_len = ulp_hdr_len;
 
-	/* write the message */
-	/* get the pointer */
-	buff = ucx_hndl->dummy_msg.out.header.iov_base;
-
-	/* pack relevant values */
-	inc_ptr(buff, xio_write_uint16(cancel_hdr->hdr_len, 0,
-				       (uint8_t *)buff));
-	inc_ptr(buff, xio_write_uint16(cancel_hdr->sn, 0,
-				       (uint8_t *)buff));
-	inc_ptr(buff, xio_write_uint32(cancel_hdr->result, 0,
-				       (uint8_t *)buff));
-	inc_ptr(buff, xio_write_uint16((uint16_t)(ulp_msg_sz), 0,
-				       (uint8_t *)buff));
-	inc_ptr(buff, xio_write_array((const uint8_t *)ulp_msg, ulp_msg_sz, 0,
-				      (uint8_t *)buff));
-
 	task->omsg = &ucx_hndl->dummy_msg;
 
 	/* write xio header to the buffer */
@@ -3039,6 +3681,21 @@ static int xio_ucx_send_cancel(struct xio_ucx_transport *ucx_hndl,
 	if (retval)
 		return -1;
 
+	/* write the message straight into the room reserved in the mbuf */
+	buff = (uint8_t *)xio_mbuf_get_curr_ptr(&task->mbuf) - ulp_hdr_len;
+
+	/* pack relevant values */
+	inc_ptr(buff, xio_write_uint16(cancel_hdr->hdr_len, 0,
+				       (uint8_t *)buff));
+	inc_ptr(buff, xio_write_uint16(cancel_hdr->sn, 0,
+				       (uint8_t *)buff));
+	inc_ptr(buff, xio_write_uint32(cancel_hdr->result, 0,
+				       (uint8_t *)buff));
+	inc_ptr(buff, xio_write_uint16((uint16_t)(ulp_msg_sz), 0,
+				       (uint8_t *)buff));
+	inc_ptr(buff, xio_write_array((const uint8_t *)ulp_msg, ulp_msg_sz, 0,
+				      (uint8_t *)buff));
+
 	/* set the length */
 	ucx_task->txd.msg_len		 = 1;
 	ucx_task->txd.tot_iov_byte_len	 = 0;
@@ -3051,12 +3708,11 @@ static int xio_ucx_send_cancel(struct xio_ucx_transport *ucx_hndl,
 		return  -1;
 
 	task->omsg = NULL;
-	free(ucx_hndl->dummy_msg.out.header.iov_base);
 
-	ucx_hndl->tx_ready_tasks_num++;
-	list_move_tail(&task->tasks_list_entry, &ucx_hndl->tx_ready_list);
+	xio_ucx_tx_enqueue(ucx_hndl, task);
 
-	xio_ucx_xmit(ucx_hndl);
+	if (flush)
+		xio_ucx_xmit(ucx_hndl);
 
 	return 0;
 }
@@ -3092,6 +3748,39 @@ int xio_ucx_send(struct xio_transport_base *transport,
 	return retval;
 }
 
+/*---------------------------------------------------------------------------*/
+/* xio_ucx_send_batch							     */
+/*---------------------------------------------------------------------------*/
+int xio_ucx_send_batch(struct xio_transport_base *transport,
+		       struct xio_task **tasks, int nr)
+{
+	struct xio_ucx_transport *ucx_hndl =
+		(struct xio_ucx_transport *)transport;
+	int	i;
+
+	/* prep and queue everything, then write it in one xmit pass */
+	ucx_hndl->tx_batching = 1;
+	for (i = 0; i < nr; i++) {
+		if (xio_ucx_send(transport, tasks[i]) != 0)
+			break;
+	}
+	ucx_hndl->tx_batching = 0;
+
+	if (i == 0 && nr)
+		return -1;
+
+	/* the first i tasks are queued on tx_ready whatever the flush
+	 * says - they belong to the transport now and go out on the next
+	 * pass, or are flushed on disconnect. the error stays in xio_errno
+	 */
+	if (ucx_hndl->tx_ready_tasks_num && xio_ucx_tx_flush(ucx_hndl) != 0)
+		xio_context_add_event(ucx_hndl->base.ctx,
+				      &ucx_hndl->flush_tx_event);
+
+	/* number of tasks accepted; the caller retries the rest */
+	return i;
+}
+
 /*---------------------------------------------------------------------------*/
 /* xio_ucx_get_data_rxd							     */
 /*---------------------------------------------------------------------------*/
@@ -3124,8 +3813,9 @@ int xio_ucx_rx_data_handler(struct xio_ucx_transport *ucx_hndl, int batch_nr)
 	int retval = 0, recvmsg_retval = 0;
 	struct xio_ucx_task *ucx_task, *next_ucx_task;
 	struct xio_task *task, *next_task/*, *task1 = NULL, *task2*/;
-	unsigned int i, last_in_rxq;
+	unsigned int i, rx_idx, last_in_rxq;
 	int batch_count = 0, tmp_count = 0, ret_count = 0;
+	int last_app = -1;
 	unsigned int iov_len;
 	uint64_t bytes_recv;
 	struct xio_ucx_work_req *rxd_work, *next_rxd_work;
@@ -3172,6 +3862,12 @@ int xio_ucx_rx_data_handler(struct xio_ucx_transport *ucx_hndl, int batch_nr)
 		ucx_hndl->tmp_work.tot_iov_byte_len +=
 				rxd_work->tot_iov_byte_len;
 
+		/* headers are parsed already - remember the last
+		 * application message while gathering
+		 */
+		if (IS_APPLICATION_MSG(task->tlv_type))
+			last_app = tmp_count;
+
 		++batch_count;
 		++tmp_count;
 
@@ -3224,21 +3920,31 @@ int xio_ucx_rx_data_handler(struct xio_ucx_transport *ucx_hndl, int batch_nr)
 		ucx_hndl->tmp_work.msg_len = 0;
 		ucx_hndl->tmp_work.tot_iov_byte_len = 0;
 
-                /* look for the maximum last in rxq index */
-                tmp_count = 0;
-                last_in_rxq = 0;
-                list_for_each_entry(task, &ucx_hndl->rx_list, tasks_list_entry) {
-                        if (IS_APPLICATION_MSG(task->tlv_type))
-                                last_in_rxq = (int)tmp_count;
-                        if (++tmp_count == (int)i)
-                                break;
-                }
-                tmp_count = 0;
+		/* last application message among the i received tasks.
+		 * only a short read that cut it off needs a look back
+		 */
+		if (last_app < (int)i) {
+			last_in_rxq = last_app < 0 ? 0 : last_app;
+		} else {
+			last_in_rxq = 0;
+			rx_idx = 0;
+			list_for_each_entry(task, &ucx_hndl->rx_list,
+					    tasks_list_entry) {
+				if (rx_idx == i)
+					break;
+				if (IS_APPLICATION_MSG(task->tlv_type))
+					last_in_rxq = rx_idx;
+				++rx_idx;
+			}
+		}
+		tmp_count = 0;
+		last_app = -1;
 
 		task = list_first_entry(&ucx_hndl->rx_list, struct xio_task,
 					tasks_list_entry);
+		rx_idx = 0;
 		while (i--) {
-                        task->last_in_rxq = (ret_count == (int)last_in_rxq);
+			task->last_in_rxq = (rx_idx++ == last_in_rxq);
 			++ret_count;
 			ucx_task = (struct xio_ucx_task *)task->dd_data;
 			switch (task->tlv_type) {
@@ -3336,8 +4042,13 @@ int xio_ucx_rx_ctl_handler(struct xio_ucx_transport *ucx_hndl, int batch_nr)
 				task_next =
 					xio_ucx_primary_task_alloc(ucx_hndl);
 				if (!task_next) {
-					ERROR_LOG(
+					/* log once per episode; the next task
+					 * put back re-arms ctl_rx_event
+					 */
+					if (!ucx_hndl->rx_pool_starved)
+						ERROR_LOG(
 						"primary task pool is empty\n");
+					ucx_hndl->rx_pool_starved = 1;
 					exit = 1;
 					continue;
 				} else {
@@ -3511,6 +4222,99 @@ int xio_ucx_poll(struct xio_transport_base *transport,
 	return nr_comp;
 }
 
+/*---------------------------------------------------------------------------*/
+/* xio_ucx_poll_completions						     */
+/*---------------------------------------------------------------------------*/
+int xio_ucx_poll_completions(struct xio_transport_base *transport,
+			     struct xio_transport_wc *wc, long max_nr,
+			     struct timespec *ts_timeout)
+{
+	struct xio_ucx_transport	*ucx_hndl;
+	int				nr_comp, recv_counter;
+	cycles_t			timeout = -1;
+	cycles_t			start_time = get_cycles();
+
+	if (max_nr <= 0)
+		return -1;
+
+	if (ts_timeout)
+		timeout = (cycles_t)(timespec_to_usecs(ts_timeout) * g_mhz);
+
+	ucx_hndl = (struct xio_ucx_transport *)transport;
+
+	if (ucx_hndl->state != XIO_TRANSPORT_STATE_CONNECTED) {
+		ERROR_LOG("ucx transport is not connected, state=%d\n",
+			  ucx_hndl->state);
+		return -1;
+	}
+
+	/* completions land in wc[] instead of the observer callbacks */
+	ucx_hndl->poll_wc	= wc;
+	ucx_hndl->poll_wc_nr	= 0;
+	ucx_hndl->poll_wc_max	= max_nr;
+
+	while (1) {
+		/* the caller owns the pacing - don't wait for comp_batch */
+		if (ucx_hndl->tx_comp_cnt &&
+		    !list_empty(&ucx_hndl->in_flight_list))
+			xio_ucx_tx_comp_now(ucx_hndl);
+
+		recv_counter = ucx_hndl->tcp_sock.ops.rx_ctl_handler(ucx_hndl);
+		if (recv_counter < 0 && xio_errno() != XIO_EAGAIN)
+			break;
+
+		if (ucx_hndl->poll_wc_nr == ucx_hndl->poll_wc_max)
+			break;
+		/* run to completion: hand back what we have once rx idles */
+		if (ucx_hndl->poll_wc_nr && recv_counter <= 0)
+			break;
+		if ((get_cycles() - start_time) >= timeout)
+			break;
+	}
+
+	nr_comp = ucx_hndl->poll_wc_nr;
+	ucx_hndl->poll_wc = NULL;
+
+	return nr_comp;
+}
+
+/*---------------------------------------------------------------------------*/
+/* xio_ucx_cancel_drop							     */
+/*---------------------------------------------------------------------------*/
+static void xio_ucx_cancel_drop(struct xio_ucx_transport *ucx_hndl,
+				struct xio_task *ptask,
+				void *ulp_msg, size_t ulp_msg_sz)
+{
+	union xio_transport_event_data	event_data;
+
+	XIO_TO_UCX_TASK(ptask, ucx_task);
+
+	if (ucx_task->tx_credit_parked)
+		ucx_task->tx_credit_parked = 0;
+	else
+		ucx_hndl->tx_ready_tasks_num--;
+	list_move_tail(&ptask->tasks_list_entry, &ucx_hndl->tx_comp_list);
+
+	/* a credit reserved for it goes to the next parked request */
+	if (ucx_task->tx_credit_held) {
+		ucx_task->tx_credit_held = 0;
+		xio_ucx_tx_credit_return(ucx_hndl, ptask);
+	}
+
+	/* return decrease ref count from task */
+	xio_tasks_pool_put(ptask);
+
+	/* fill notification event */
+	event_data.cancel.ulp_msg	=  ulp_msg;
+	event_data.cancel.ulp_msg_sz	=  ulp_msg_sz;
+	event_data.cancel.task		=  ptask;
+	event_data.cancel.result	=  XIO_E_MSG_CANCELED;
+
+	xio_transport_notify_observer(&ucx_hndl->base,
+				      XIO_TRANSPORT_EVENT_CANCEL_RESPONSE,
+				      &event_data);
+}
+
 /*---------------------------------------------------------------------------*/
 /* xio_ucx_cancel_req							     */
 /*---------------------------------------------------------------------------*/
@@ -3520,66 +4324,28 @@ int xio_ucx_cancel_req(struct xio_transport_base *transport,
 {
 	struct xio_ucx_transport *ucx_hndl =
 		(struct xio_ucx_transport *)transport;
-	struct xio_task			*ptask, *next_ptask;
+	struct xio_task			*ptask;
 	union xio_transport_event_data	event_data;
 	struct xio_ucx_task		*ucx_task;
 	struct xio_ucx_cancel_hdr	cancel_hdr = {
 		.hdr_len = sizeof(cancel_hdr),
 	};
 
-	/* look in the tx_ready */
-	list_for_each_entry_safe(ptask, next_ptask, &ucx_hndl->tx_ready_list,
-				 tasks_list_entry) {
-		if (ptask->omsg &&
-		    (ptask->omsg->sn == req->sn) &&
-		    (ptask->stag == stag)) {
+	ptask = xio_ucx_cancel_hash_lookup(ucx_hndl, req->sn, stag);
+	if (ptask) {
+		ucx_task = (struct xio_ucx_task *)ptask->dd_data;
+
+		/* not a single byte on the wire yet - drop it locally */
+		if (ucx_task->txd.stage == XIO_UCX_TX_BEFORE) {
 			TRACE_LOG("[%lu] - message found on tx_ready_list\n",
 				  req->sn);
-
-			ucx_task = (struct xio_ucx_task *)ptask->dd_data;
-
-			if (ucx_task->txd.stage != XIO_UCX_TX_BEFORE)
-				goto send_cancel;
-
-			/* return decrease ref count from task */
-			xio_tasks_pool_put(ptask);
-			ucx_hndl->tx_ready_tasks_num--;
-			list_move_tail(&ptask->tasks_list_entry,
-				       &ucx_hndl->tx_comp_list);
-
-			/* fill notification event */
-			event_data.cancel.ulp_msg	=  ulp_msg;
-			event_data.cancel.ulp_msg_sz	=  ulp_msg_sz;
-			event_data.cancel.task		=  ptask;
-			event_data.cancel.result	=  XIO_E_MSG_CANCELED;
-
-			xio_transport_notify_observer(
-					&ucx_hndl->base,
-					XIO_TRANSPORT_EVENT_CANCEL_RESPONSE,
-					&event_data);
+			list_del_init(&ucx_task->cancel_list_entry);
+			xio_ucx_cancel_drop(ucx_hndl, ptask,
+					    ulp_msg, ulp_msg_sz);
 			return 0;
 		}
-	}
-	/* look in the in_flight */
-	list_for_each_entry_safe(ptask, next_ptask, &ucx_hndl->in_flight_list,
-				 tasks_list_entry) {
-		if (ptask->omsg &&
-		    (ptask->omsg->sn == req->sn) &&
-		    (ptask->stag == stag) &&
-		    (ptask->state != XIO_TASK_STATE_RESPONSE_RECV)) {
-			TRACE_LOG("[%lu] - message found on in_flight_list\n",
-				  req->sn);
-			goto send_cancel;
-		}
-	}
-	/* look in the tx_comp */
-	list_for_each_entry_safe(ptask, next_ptask, &ucx_hndl->tx_comp_list,
-				 tasks_list_entry) {
-		if (ptask->omsg &&
-		    (ptask->omsg->sn == req->sn) &&
-		    (ptask->stag == stag) &&
-		    (ptask->state != XIO_TASK_STATE_RESPONSE_RECV)) {
-			TRACE_LOG("[%lu] - message found on tx_comp_list\n",
+		if (ptask->state != XIO_TASK_STATE_RESPONSE_RECV) {
+			TRACE_LOG("[%lu] - message found on tx path\n",
 				  req->sn);
 			goto send_cancel;
 		}
@@ -3605,12 +4371,91 @@ send_cancel:
 	ucx_task	= (struct xio_ucx_task *)ptask->dd_data;
 	cancel_hdr.sn	= ucx_task->sn;
 
-	xio_ucx_send_cancel(ucx_hndl, XIO_CANCEL_REQ, &cancel_hdr,
-			    ulp_msg, ulp_msg_sz);
+	if (xio_ucx_send_cancel(ucx_hndl, XIO_CANCEL_REQ, &cancel_hdr,
+				ulp_msg, ulp_msg_sz, 1) == 0)
+		ucx_task->cancel_sent = 1;
 
 	return 0;
 }
 
+/*---------------------------------------------------------------------------*/
+/* xio_ucx_cancel_all_req						     */
+/*---------------------------------------------------------------------------*/
+int xio_ucx_cancel_all_req(struct xio_transport_base *transport,
+			   void *ulp_msg, size_t ulp_msg_sz)
+{
+	struct xio_ucx_transport *ucx_hndl =
+		(struct xio_ucx_transport *)transport;
+	struct xio_ucx_task		*ucx_task, *next_ucx_task;
+	struct xio_task			*ptask, *next_ptask;
+	struct xio_ucx_cancel_hdr	cancel_hdr = {
+		.hdr_len = sizeof(cancel_hdr),
+	};
+	LIST_HEAD(dropped);
+	uint32_t			i;
+	int				nr_queued = 0, nr_left = 0;
+	int				retval = 0;
+
+	/* one pass over every outstanding request: unsent ones are pulled
+	 * aside, the rest get a cancel frame queued without transmitting.
+	 * each frame takes a primary task, the same pool receive refills
+	 * from, so at most TX_BATCH go out per call; the caller retries on
+	 * XIO_EAGAIN once they complete
+	 */
+	for (i = 0; i <= ucx_hndl->cancel_hash_mask; i++) {
+		list_for_each_entry_safe(ucx_task, next_ucx_task,
+					 &ucx_hndl->cancel_hash[i],
+					 cancel_list_entry) {
+			ptask = ucx_task->task;
+			if (ucx_task->txd.stage == XIO_UCX_TX_BEFORE) {
+				list_del_init(&ucx_task->cancel_list_entry);
+				list_move_tail(&ptask->tasks_list_entry,
+					       &dropped);
+				continue;
+			}
+			if (ptask->state == XIO_TASK_STATE_RESPONSE_RECV ||
+			    ucx_task->cancel_sent)
+				continue;
+			if (nr_queued == TX_BATCH) {
+				nr_left++;
+				continue;
+			}
+
+			cancel_hdr.sn = ucx_task->sn;
+			if (xio_ucx_send_cancel(ucx_hndl, XIO_CANCEL_REQ,
+						&cancel_hdr, ulp_msg,
+						ulp_msg_sz, 0) == 0) {
+				ucx_task->cancel_sent = 1;
+				nr_queued++;
+			} else if (!retval) {
+				/* keep going, report the first failure */
+				ERROR_LOG("cancel all: sn:%u not sent\n",
+					  ucx_task->sn);
+				retval = -1;
+			}
+		}
+	}
+
+	/* the observer may release tasks, so notify outside the walk */
+	list_for_each_entry_safe(ptask, next_ptask, &dropped,
+				 tasks_list_entry)
+		xio_ucx_cancel_drop(ucx_hndl, ptask, ulp_msg, ulp_msg_sz);
+
+	/* all cancel frames leave in as few sendmsg calls as possible */
+	if (nr_queued)
+		xio_ucx_xmit(ucx_hndl);
+
+	TRACE_LOG("cancel all: %d queued to peer, %d left\n",
+		  nr_queued, nr_left);
+
+	if (!retval && nr_left) {
+		xio_set_error(XIO_EAGAIN);
+		retval = -1;
+	}
+
+	return retval;
+}
+
 /*---------------------------------------------------------------------------*/
 /* xio_ucx_cancel_rsp							     */
 /*---------------------------------------------------------------------------*/
@@ -3646,6 +4491,6 @@ int xio_ucx_cancel_rsp(struct xio_transport_base *transport,
 	/* fill dummy transport header since was handled by upper layer
 	 */
 	return xio_ucx_send_cancel(ucx_hndl, XIO_CANCEL_RSP,
-				   &cancel_hdr, ulp_msg, ulp_msg_sz);
+				   &cancel_hdr, ulp_msg, ulp_msg_sz, 1);
 }
 
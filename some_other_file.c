@@ -39,6 +39,7 @@
 #include <xio_predefs.h>
 #include <xio_env.h>
 #include <xio_os.h>
+#include <sys/eventfd.h>
 #include "libxio.h"
 #include "xio_log.h"
 #include "xio_common.h"
@@ -57,6 +58,9 @@
 #include "xio_ucx_transport.h"
 #include "xio_mem.h"
 #include "xio_ucx_transport.h"
+#ifdef SO_ATTACH_REUSEPORT_CBPF
+#include <linux/filter.h>
+#endif
 
 /* default option values */
 #define XIO_OPTVAL_DEF_ENABLE_MEM_POOL			1
@@ -68,6 +72,23 @@
 #define XIO_OPTVAL_DEF_UCX_SO_SNDBUF			4194304
 #define XIO_OPTVAL_DEF_UCX_SO_RCVBUF			4194304
 #define XIO_OPTVAL_DEF_UCX_DUAL_SOCK			1
+#define XIO_OPTVAL_DEF_UCX_EDGE_TRIGGERED		0
+#define XIO_OPTVAL_DEF_UCX_BUSY_POLL			0
+#define XIO_OPTVAL_DEF_UCX_REUSEPORT			0
+#define XIO_OPTVAL_DEF_UCX_SO_AUTOTUNE			0
+#define XIO_OPTVAL_DEF_UCX_BATCH_LAT_USEC		0
+#define XIO_OPTVAL_DEF_UCX_TX_COPY_THRESHOLD		0
+#define XIO_OPTVAL_DEF_UCX_COALESCE_MSGS		0
+#define XIO_OPTVAL_DEF_UCX_COALESCE_BYTES		65536
+#define XIO_OPTVAL_DEF_UCX_FLOW_CREDITS		0
+#define XIO_OPTVAL_DEF_UCX_COMP_DEADLINE_MSEC		0
+#define XIO_OPTVAL_DEF_UCX_TX_PRIO_WEIGHT		8
+#define XIO_OPTVAL_DEF_UCX_TX_PASS_BYTES		0
+#define XIO_OPTVAL_DEF_UCX_RX_QUANTUM_USEC		0
+
+/* auto tuned socket buffers start here and halve back to it when idle */
+#define XIO_UCX_SOCKBUF_MIN				65536
+#define XIO_UCX_SOCKBUF_IDLE_NR				256
 
 /*---------------------------------------------------------------------------*/
 /* globals								     */
@@ -92,9 +113,38 @@ struct xio_ucx_options			ucx_options = {
 	XIO_OPTVAL_DEF_UCX_SO_SNDBUF,		/*ucx_so_sndbuf*/
 	XIO_OPTVAL_DEF_UCX_SO_RCVBUF,		/*ucx_so_rcvbuf*/
 	XIO_OPTVAL_DEF_UCX_DUAL_SOCK,		/*ucx_dual_sock*/
+	XIO_OPTVAL_DEF_UCX_EDGE_TRIGGERED,	/*ucx_edge_triggered*/
+	XIO_OPTVAL_DEF_UCX_BUSY_POLL,		/*ucx_busy_poll*/
+	XIO_OPTVAL_DEF_UCX_REUSEPORT,		/*ucx_reuseport*/
+	XIO_OPTVAL_DEF_UCX_SO_AUTOTUNE,		/*ucx_so_autotune*/
+	XIO_OPTVAL_DEF_UCX_BATCH_LAT_USEC,	/*ucx_batch_lat_usec*/
+	XIO_OPTVAL_DEF_UCX_TX_COPY_THRESHOLD,	/*ucx_tx_copy_threshold*/
+	XIO_OPTVAL_DEF_UCX_COALESCE_MSGS,	/*ucx_coalesce_msgs*/
+	XIO_OPTVAL_DEF_UCX_COALESCE_BYTES,	/*ucx_coalesce_bytes*/
+	XIO_OPTVAL_DEF_UCX_FLOW_CREDITS,	/*ucx_flow_credits*/
+	XIO_OPTVAL_DEF_UCX_COMP_DEADLINE_MSEC,	/*ucx_comp_deadline_msec*/
+	XIO_OPTVAL_DEF_UCX_TX_PRIO_WEIGHT,	/*ucx_tx_prio_weight*/
+	XIO_OPTVAL_DEF_UCX_TX_PASS_BYTES,	/*ucx_tx_pass_bytes*/
+	XIO_OPTVAL_DEF_UCX_RX_QUANTUM_USEC,	/*ucx_rx_quantum_usec*/
 	0					/*pad*/
 };
 
+/* socket buffer bytes currently requested by all connections */
+static uint64_t ucx_so_sndbuf_inuse;
+static uint64_t ucx_so_rcvbuf_inuse;
+
+/* EAGAIN retries that ended without the socket draining */
+uint64_t ucx_tx_spin_wasted;
+
+/* batch size adjustments made by all connections */
+uint64_t ucx_batch_grow_cnt;
+uint64_t ucx_batch_shrink_cnt;
+
+/* sendmsg calls made by all connections - messages sent over this
+ * count is the coalescing ratio
+ */
+uint64_t ucx_tx_sendmsg_cnt;
+
 /*---------------------------------------------------------------------------*/
 /* xio_ucx_get_max_header_size						     */
 /*---------------------------------------------------------------------------*/
@@ -121,11 +171,39 @@ int xio_ucx_get_inline_buffer_size(void)
 	return inline_buf_sz;
 }
 
+/*---------------------------------------------------------------------------*/
+/* xio_ucx_mpsc_close							     */
+/*---------------------------------------------------------------------------*/
+static void xio_ucx_mpsc_close(struct xio_ucx_transport *ucx_hndl)
+{
+	struct xio_ucx_task *ucx_task, *next;
+
+	/* new producers fail with XIO_E_STATE from here on; wait out the
+	 * ones already inside send_mt so none touches the stack or
+	 * mpsc_efd after this returns
+	 */
+	__sync_lock_test_and_set(&ucx_hndl->mpsc_closing, 1);
+	__sync_synchronize();
+	while (__sync_fetch_and_add(&ucx_hndl->mpsc_users, 0))
+		;
+
+	/* submissions nobody drained were never prepped or queued -
+	 * just give them back
+	 */
+	ucx_task = __sync_lock_test_and_set(&ucx_hndl->mpsc_head, NULL);
+	for (; ucx_task; ucx_task = next) {
+		next = ucx_task->mpsc_next;
+		xio_tasks_pool_put(ucx_task->task);
+	}
+}
+
 /*---------------------------------------------------------------------------*/
 /* xio_ucx_flush_all_tasks						     */
 /*---------------------------------------------------------------------------*/
 static int xio_ucx_flush_all_tasks(struct xio_ucx_transport *ucx_hndl)
 {
+	xio_ucx_mpsc_close(ucx_hndl);
+
 	if (!list_empty(&ucx_hndl->in_flight_list)) {
 		TRACE_LOG("in_flight_list not empty!\n");
 		xio_transport_flush_task_list(&ucx_hndl->in_flight_list);
@@ -149,6 +227,13 @@ static int xio_ucx_flush_all_tasks(struct xio_ucx_transport *ucx_hndl)
 		xio_transport_flush_task_list(&ucx_hndl->tx_ready_list);
 	}
 
+	if (!list_empty(&ucx_hndl->tx_credit_list)) {
+		TRACE_LOG("tx_credit_list not empty!\n");
+		xio_transport_flush_task_list(&ucx_hndl->tx_credit_list);
+		/* for task that attached to senders with ref count = 2 */
+		xio_transport_flush_task_list(&ucx_hndl->tx_credit_list);
+	}
+
 	if (!list_empty(&ucx_hndl->rx_list)) {
 		TRACE_LOG("rx_list not empty!\n");
 		xio_transport_flush_task_list(&ucx_hndl->rx_list);
@@ -183,6 +268,24 @@ int xio_ucx_single_sock_del_ev_handlers(struct xio_ucx_transport *ucx_hndl)
 {
 	int retval;
 
+	if (ucx_hndl->mpsc_in_epoll) {
+		retval = xio_context_del_ev_handler(ucx_hndl->base.ctx,
+						    ucx_hndl->mpsc_efd);
+		if (retval)
+			ERROR_LOG("ucx_hndl:%p fd=%d del_ev_handler failed, %m\n",
+				  ucx_hndl, ucx_hndl->mpsc_efd);
+		ucx_hndl->mpsc_in_epoll = 0;
+	}
+
+	if (ucx_hndl->in_epoll[1]) {
+		retval = xio_context_del_ev_handler(ucx_hndl->base.ctx,
+						    ucx_hndl->tcp_sock.cfd);
+		if (retval)
+			ERROR_LOG("ucx_hndl:%p fd=%d del_ev_handler failed, %m\n",
+				  ucx_hndl, ucx_hndl->tcp_sock.cfd);
+		ucx_hndl->in_epoll[1] = 0;
+	}
+
         if (ucx_hndl->in_epoll[0])
                 return 0;
 
@@ -216,6 +319,8 @@ static void on_sock_disconnected(struct xio_ucx_transport *ucx_hndl,
 
 		xio_context_disable_event(&ucx_hndl->flush_tx_event);
 		xio_context_disable_event(&ucx_hndl->ctl_rx_event);
+		xio_ctx_del_delayed_work(ucx_hndl->base.ctx,
+					 &ucx_hndl->comp_deadline_work);
 
 		if (ucx_hndl->tcp_sock.ops.del_ev_handlers)
 			ucx_hndl->tcp_sock.ops.del_ev_handlers(ucx_hndl);
@@ -253,6 +358,9 @@ static void on_sock_disconnected(struct xio_ucx_transport *ucx_hndl,
 /*---------------------------------------------------------------------------*/
 static void xio_ucx_post_close(struct xio_ucx_transport *ucx_hndl)
 {
+	struct list_head	*pos, *next;
+	uint32_t		i;
+
 	TRACE_LOG("ucx transport: [post close] handle:%p\n",
 		  ucx_hndl);
 
@@ -260,11 +368,37 @@ static void xio_ucx_post_close(struct xio_ucx_transport *ucx_hndl)
 
 	xio_observable_unreg_all_observers(&ucx_hndl->base.observable);
 
+	__sync_fetch_and_sub(&ucx_so_sndbuf_inuse, ucx_hndl->so_sndbuf);
+	__sync_fetch_and_sub(&ucx_so_rcvbuf_inuse, ucx_hndl->so_rcvbuf);
+
 	if (ucx_hndl->tmp_rx_buf) {
 		ufree(ucx_hndl->tmp_rx_buf);
 		ucx_hndl->tmp_rx_buf = NULL;
 	}
 
+	if (ucx_hndl->cancel_hash) {
+		/* tasks outlive the transport - unhook them from the buckets */
+		for (i = 0; i <= ucx_hndl->cancel_hash_mask; i++) {
+			list_for_each_safe(pos, next,
+					   &ucx_hndl->cancel_hash[i])
+				list_del_init(pos);
+		}
+		ufree(ucx_hndl->cancel_hash);
+		ucx_hndl->cancel_hash = NULL;
+	}
+
+	if (ucx_hndl->sn_index) {
+		ufree(ucx_hndl->sn_index);
+		ucx_hndl->sn_index = NULL;
+	}
+
+	/* producers are fenced off before the eventfd goes away */
+	xio_ucx_mpsc_close(ucx_hndl);
+	if (ucx_hndl->mpsc_efd >= 0) {
+		close(ucx_hndl->mpsc_efd);
+		ucx_hndl->mpsc_efd = -1;
+	}
+
 	ufree(ucx_hndl->base.portal_uri);
 
 	XIO_OBSERVABLE_DESTROY(&ucx_hndl->base.observable);
@@ -452,7 +586,173 @@ void xio_ucx_flush_tx_handler(void *xio_ucx_hndl)
 /*---------------------------------------------------------------------------*/
 int xio_ucx_single_sock_rx_ctl_handler(struct xio_ucx_transport *ucx_hndl)
 {
-	return xio_ucx_rx_ctl_handler(ucx_hndl, 1);
+	/* one message per call unless adaptive batching is enabled */
+	return xio_ucx_rx_ctl_handler(ucx_hndl,
+				      ucx_options.ucx_batch_lat_usec ?
+				      ucx_hndl->rx_batch : 1);
+}
+
+/*---------------------------------------------------------------------------*/
+/* xio_ucx_sockbuf_initial						     */
+/*---------------------------------------------------------------------------*/
+static inline int xio_ucx_sockbuf_initial(int limit)
+{
+	if (!ucx_options.ucx_so_autotune)
+		return limit;
+
+	return min(XIO_UCX_SOCKBUF_MIN, limit);
+}
+
+/*---------------------------------------------------------------------------*/
+/* xio_ucx_sockbuf_tune							     */
+/*---------------------------------------------------------------------------*/
+void xio_ucx_sockbuf_tune(struct xio_ucx_transport *ucx_hndl, int optname,
+			  int pressure)
+{
+	int *size, *idle, limit, optval, granted;
+	socklen_t len = sizeof(granted);
+	uint64_t *inuse;
+
+	if (!ucx_options.ucx_so_autotune || ucx_hndl->tcp_sock.cfd < 0)
+		return;
+
+	if (optname == SO_SNDBUF) {
+		size	= &ucx_hndl->so_sndbuf;
+		idle	= &ucx_hndl->so_sndbuf_idle;
+		limit	= ucx_options.ucx_so_sndbuf;
+		inuse	= &ucx_so_sndbuf_inuse;
+	} else {
+		size	= &ucx_hndl->so_rcvbuf;
+		idle	= &ucx_hndl->so_rcvbuf_idle;
+		limit	= ucx_options.ucx_so_rcvbuf;
+		inuse	= &ucx_so_rcvbuf_inuse;
+	}
+
+	/* accepted sockets inherit the listener's starting size */
+	if (!*size) {
+		*size = xio_ucx_sockbuf_initial(limit);
+		__sync_fetch_and_add(inuse, *size);
+	}
+
+	/* grow fast under pressure, shrink slowly once it is gone */
+	if (pressure) {
+		*idle = 0;
+		optval = min(*size * 2, limit);
+	} else {
+		if (++(*idle) < XIO_UCX_SOCKBUF_IDLE_NR)
+			return;
+		*idle = 0;
+		optval = max(*size / 2, xio_ucx_sockbuf_initial(limit));
+	}
+	if (optval == *size)
+		return;
+
+	if (setsockopt(ucx_hndl->tcp_sock.cfd, SOL_SOCKET, optname,
+		       (char *)&optval, sizeof(optval))) {
+		ERROR_LOG("setsockopt failed. (errno=%d %m)\n",
+			  xio_get_last_socket_error());
+		return;
+	}
+
+	/* the kernel silently caps the request at wmem_max/rmem_max and
+	 * reports twice what it granted - track the real size so growth
+	 * stops at the actual ceiling and the totals stay honest
+	 */
+	if (!getsockopt(ucx_hndl->tcp_sock.cfd, SOL_SOCKET, optname,
+			(char *)&granted, &len) && granted / 2 < optval)
+		optval = granted / 2;
+	if (optval == *size)
+		return;
+
+	__sync_fetch_and_add(inuse, (int64_t)optval - *size);
+	*size = optval;
+}
+
+/*---------------------------------------------------------------------------*/
+/* xio_ucx_rx_batch_tune						     */
+/*---------------------------------------------------------------------------*/
+static void xio_ucx_rx_batch_tune(struct xio_ucx_transport *ucx_hndl,
+				  cycles_t elapsed, int backlog)
+{
+	cycles_t target = (cycles_t)(ucx_options.ucx_batch_lat_usec * g_mhz);
+
+	if (elapsed > target && ucx_hndl->rx_batch > 1) {
+		/* the round held the loop too long */
+		ucx_hndl->rx_batch /= 2;
+		__sync_fetch_and_add(&ucx_batch_shrink_cnt, 1);
+	} else if (elapsed <= target && backlog &&
+		   ucx_hndl->rx_batch < RX_BATCH) {
+		/* data left behind although time remained */
+		ucx_hndl->rx_batch++;
+		__sync_fetch_and_add(&ucx_batch_grow_cnt, 1);
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+/* xio_ucx_busy_poll_spin						     */
+/*---------------------------------------------------------------------------*/
+static inline int xio_ucx_busy_poll_spin(struct xio_ucx_transport *ucx_hndl,
+					 cycles_t *deadline)
+{
+	if (!ucx_options.ucx_busy_poll ||
+	    ucx_hndl->state != XIO_TRANSPORT_STATE_CONNECTED)
+		return 0;
+
+	/* budget starts on the first idle read of this round */
+	if (!*deadline)
+		*deadline = get_cycles() +
+			    (cycles_t)(ucx_options.ucx_busy_poll * g_mhz);
+
+	return get_cycles() < *deadline;
+}
+
+/*---------------------------------------------------------------------------*/
+/* xio_ucx_rx_round_start						     */
+/*---------------------------------------------------------------------------*/
+static inline void xio_ucx_rx_round_start(struct xio_ucx_transport *ucx_hndl)
+{
+	int64_t quantum;
+
+	/* deficit round robin: every round adds one quantum of cpu time.
+	 * a round that stopped early on RX_POLL_NR_MAX leaves credit
+	 * behind - never carry more than one quantum into a round, or a
+	 * bursty connection could later hold the loop for several
+	 */
+	if (ucx_options.ucx_rx_quantum_usec) {
+		quantum = (int64_t)(ucx_options.ucx_rx_quantum_usec * g_mhz);
+		ucx_hndl->rx_deficit = min(ucx_hndl->rx_deficit + quantum,
+					   quantum);
+	}
+	ucx_hndl->rx_round_start = get_cycles();
+}
+
+/*---------------------------------------------------------------------------*/
+/* xio_ucx_rx_budget_left						     */
+/*---------------------------------------------------------------------------*/
+static inline int xio_ucx_rx_budget_left(struct xio_ucx_transport *ucx_hndl)
+{
+	return !ucx_options.ucx_rx_quantum_usec ||
+	       (int64_t)(get_cycles() - ucx_hndl->rx_round_start) <
+			ucx_hndl->rx_deficit;
+}
+
+/*---------------------------------------------------------------------------*/
+/* xio_ucx_rx_round_end							     */
+/*---------------------------------------------------------------------------*/
+static inline void xio_ucx_rx_round_end(struct xio_ucx_transport *ucx_hndl,
+					int backlog)
+{
+	if (!ucx_options.ucx_rx_quantum_usec)
+		return;
+
+	/* an overrun is paid back next round; a connection with nothing
+	 * pending does not bank credit
+	 */
+	if (backlog || ucx_hndl->tmp_rx_buf_len)
+		ucx_hndl->rx_deficit -= (int64_t)
+			(get_cycles() - ucx_hndl->rx_round_start);
+	else
+		ucx_hndl->rx_deficit = 0;
 }
 
 /*---------------------------------------------------------------------------*/
@@ -463,15 +763,48 @@ void xio_ucx_consume_ctl_rx(void *xio_ucx_hndl)
 	struct xio_ucx_transport *ucx_hndl = (struct xio_ucx_transport *)
 						xio_ucx_hndl;
 	int retval = 0, count = 0;
+	int spinning;
+	cycles_t deadline = 0;
+	cycles_t start = 0, spun = 0, t = 0;
 
 	xio_context_disable_event(&ucx_hndl->ctl_rx_event);
 
+	if (ucx_options.ucx_batch_lat_usec)
+		start = get_cycles();
+	xio_ucx_rx_round_start(ucx_hndl);
 	do {
+		spinning = 0;
+		if (ucx_options.ucx_busy_poll)
+			t = get_cycles();
 		retval = ucx_hndl->tcp_sock.ops.rx_ctl_handler(ucx_hndl);
+		if (retval == 0 &&
+		    xio_ucx_busy_poll_spin(ucx_hndl, &deadline)) {
+			/* socket is idle - spin in the driver, not in epoll.
+			 * an idle read is not progress: retval stays 0 so a
+			 * round cut short while spinning reports no backlog
+			 */
+			spinning = 1;
+			spun += get_cycles() - t;
+			continue;
+		}
 		++count;
-	} while (retval > 0 && count <  RX_POLL_NR_MAX);
-
-	if (/*retval > 0 && */ ucx_hndl->tmp_rx_buf_len &&
+	} while ((retval > 0 || spinning) && count <  RX_POLL_NR_MAX &&
+		 xio_ucx_rx_budget_left(ucx_hndl));
+	xio_ucx_rx_round_end(ucx_hndl, retval > 0);
+
+	/* receive budget exhausted with data still queued */
+	xio_ucx_sockbuf_tune(ucx_hndl, SO_RCVBUF, retval > 0);
+	if (ucx_options.ucx_batch_lat_usec)
+		xio_ucx_rx_batch_tune(ucx_hndl, get_cycles() - start - spun,
+				      retval > 0);
+
+	/* out of quantum - go to the back of the line, behind the
+	 * other connections of this context. edge triggered sockets
+	 * get no new edge either, so keep going until recv hits EAGAIN
+	 */
+	if ((ucx_hndl->tmp_rx_buf_len ||
+	     (retval > 0 && (ucx_options.ucx_rx_quantum_usec ||
+			     ucx_options.ucx_edge_triggered))) &&
 	    ucx_hndl->state == XIO_TRANSPORT_STATE_CONNECTED) {
 		xio_context_add_event(ucx_hndl->base.ctx,
 				      &ucx_hndl->ctl_rx_event);
@@ -513,19 +846,38 @@ void xio_ucx_data_ready_ev_handler(int fd, int events, void *user_context)
 	struct xio_ucx_transport	*ucx_hndl = (struct xio_ucx_transport *)
 							user_context;
 	int retval = 0, count = 0;
-
-	if (events & XIO_POLLOUT) {
-		xio_context_modify_ev_handler(ucx_hndl->base.ctx, fd,
-					      XIO_POLLIN | XIO_POLLRDHUP);
+	cycles_t start = 0;
+
+	if ((events & XIO_POLLOUT) && ucx_hndl->tx_blocked) {
+		ucx_hndl->tx_blocked = 0;
+		if (!ucx_options.ucx_edge_triggered)
+			xio_context_modify_ev_handler(ucx_hndl->base.ctx, fd,
+						      XIO_POLLIN |
+						      XIO_POLLRDHUP);
 		xio_ucx_xmit(ucx_hndl);
 	}
 
 	if (events & XIO_POLLIN) {
+		if (ucx_options.ucx_batch_lat_usec)
+			start = get_cycles();
+		xio_ucx_rx_round_start(ucx_hndl);
 		do {
 			retval = ucx_hndl->tcp_sock.ops.rx_data_handler(
-							ucx_hndl, RX_BATCH);
+						ucx_hndl, ucx_hndl->rx_batch);
 			++count;
-		} while (retval > 0 && count <  RX_POLL_NR_MAX);
+		} while (retval > 0 && count <  RX_POLL_NR_MAX &&
+			 xio_ucx_rx_budget_left(ucx_hndl));
+		xio_ucx_rx_round_end(ucx_hndl, retval > 0);
+
+		xio_ucx_sockbuf_tune(ucx_hndl, SO_RCVBUF, retval > 0);
+		if (ucx_options.ucx_batch_lat_usec)
+			xio_ucx_rx_batch_tune(ucx_hndl, get_cycles() - start,
+					      retval > 0);
+
+		/* no new edge will come for data left in the socket */
+		if (retval > 0 && ucx_options.ucx_edge_triggered)
+			xio_context_add_event(ucx_hndl->base.ctx,
+					      &ucx_hndl->ctl_rx_event);
 	}
 
 	if (events & (XIO_POLLHUP | XIO_POLLRDHUP | XIO_POLLERR)) {
@@ -535,6 +887,87 @@ void xio_ucx_data_ready_ev_handler(int fd, int events, void *user_context)
 	}
 }
 
+/*---------------------------------------------------------------------------*/
+/* xio_ucx_mpsc_ev_handler						     */
+/*---------------------------------------------------------------------------*/
+static void xio_ucx_mpsc_ev_handler(int fd, int events, void *user_context)
+{
+	struct xio_ucx_transport	*ucx_hndl = (struct xio_ucx_transport *)
+							user_context;
+	eventfd_t			val;
+
+	eventfd_read(fd, &val);
+
+	/* re-enable the producers' wakeup before taking the stack */
+	__sync_lock_release(&ucx_hndl->mpsc_signaled);
+
+	/* xmit drains the submission stack first thing */
+	if (ucx_hndl->mpsc_head)
+		xio_ucx_xmit(ucx_hndl);
+}
+
+/*---------------------------------------------------------------------------*/
+/* xio_ucx_single_sock_ev_handler					     */
+/*---------------------------------------------------------------------------*/
+static void xio_ucx_single_sock_ev_handler(int fd, int events,
+					   void *user_context)
+{
+	struct xio_ucx_transport	*ucx_hndl = (struct xio_ucx_transport *)
+							user_context;
+
+	if ((events & XIO_POLLOUT) && ucx_hndl->tx_blocked) {
+		ucx_hndl->tx_blocked = 0;
+		xio_ucx_single_sock_set_pollout(ucx_hndl, 0);
+		xio_ucx_xmit(ucx_hndl);
+	}
+
+	/* a single socket carries headers and payload in one stream and
+	 * only rx_ctl_handler parses headers - take the full ctl path
+	 */
+	if (events & XIO_POLLIN)
+		xio_ucx_consume_ctl_rx(ucx_hndl);
+
+	if (events & (XIO_POLLHUP | XIO_POLLRDHUP | XIO_POLLERR)) {
+		DEBUG_LOG("epoll returned with error events=%d for fd=%d\n",
+			  events, fd);
+		xio_ucx_disconnect_helper(ucx_hndl);
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+/* xio_ucx_single_sock_set_pollout					     */
+/*---------------------------------------------------------------------------*/
+int xio_ucx_single_sock_set_pollout(struct xio_ucx_transport *ucx_hndl,
+				    int on)
+{
+	int events = XIO_POLLRDHUP | (on ? XIO_POLLOUT : 0);
+	int retval;
+
+	/* edge triggered registration keeps POLLOUT armed permanently */
+	if (ucx_options.ucx_edge_triggered)
+		return 0;
+
+	/* level triggered: the data socket is only watched for POLLOUT
+	 * while a send waits on it, or the loop would spin on it
+	 */
+	if (ucx_hndl->in_epoll[1])
+		return xio_context_modify_ev_handler(ucx_hndl->base.ctx,
+						     ucx_hndl->tcp_sock.cfd,
+						     events);
+	if (!on)
+		return 0;
+
+	retval = xio_context_add_ev_handler(ucx_hndl->base.ctx,
+					    ucx_hndl->tcp_sock.cfd,
+					    events,
+					    xio_ucx_single_sock_ev_handler,
+					    ucx_hndl);
+	if (retval == 0)
+		ucx_hndl->in_epoll[1] = 1;
+
+	return retval;
+}
+
 /*---------------------------------------------------------------------------*/
 /* xio_ucx_single_sock_add_ev_handlers		                             */
 /*---------------------------------------------------------------------------*/
@@ -556,6 +989,37 @@ int xio_ucx_single_sock_add_ev_handlers(struct xio_ucx_transport *ucx_hndl)
 	}
         ucx_hndl->in_epoll[0] = 1;
 
+	/* wakeups from xio_ucx_send_mt on other threads */
+	if (!retval) {
+		retval = xio_context_add_ev_handler(ucx_hndl->base.ctx,
+						    ucx_hndl->mpsc_efd,
+						    XIO_POLLIN,
+						    xio_ucx_mpsc_ev_handler,
+						    ucx_hndl);
+		if (retval)
+			ERROR_LOG("setting submit handler failed. (errno=%d %m)\n",
+				  xio_get_last_socket_error());
+		else
+			ucx_hndl->mpsc_in_epoll = 1;
+	}
+
+	if (retval || !ucx_options.ucx_edge_triggered)
+		return retval;
+
+	/* data socket: POLLIN and POLLOUT armed once, edge triggered */
+	retval = xio_context_add_ev_handler(
+			ucx_hndl->base.ctx,
+			ucx_hndl->tcp_sock.cfd,
+			XIO_POLLIN | XIO_POLLOUT | XIO_POLLRDHUP | XIO_POLLET,
+			xio_ucx_single_sock_ev_handler,
+			ucx_hndl);
+	if (retval) {
+		ERROR_LOG("setting data handler failed. (errno=%d %m)\n",
+			  xio_get_last_socket_error());
+		return retval;
+	}
+	ucx_hndl->in_epoll[1] = 1;
+
 	return retval;
 }
 
@@ -623,7 +1087,7 @@ int xio_ucx_socket_create(void)
 		}
 	}
 
-	optval = ucx_options.ucx_so_sndbuf;
+	optval = xio_ucx_sockbuf_initial(ucx_options.ucx_so_sndbuf);
 	retval = setsockopt(sock_fd, SOL_SOCKET, SO_SNDBUF,
 			    (char *)&optval, sizeof(optval));
 	if (retval) {
@@ -632,7 +1096,7 @@ int xio_ucx_socket_create(void)
 			  xio_get_last_socket_error());
 		goto cleanup;
 	}
-	optval = ucx_options.ucx_so_rcvbuf;
+	optval = xio_ucx_sockbuf_initial(ucx_options.ucx_so_rcvbuf);
 	retval = setsockopt(sock_fd, SOL_SOCKET, SO_RCVBUF,
 			    (char *)&optval, sizeof(optval));
 	if (retval) {
@@ -642,6 +1106,26 @@ int xio_ucx_socket_create(void)
 		goto cleanup;
 	}
 
+#ifdef SO_BUSY_POLL
+	if (ucx_options.ucx_busy_poll) {
+		/* raising above net.core.busy_read needs CAP_NET_ADMIN,
+		 * so fall back to interrupt driven receive on failure
+		 */
+		optval = ucx_options.ucx_busy_poll;
+		if (setsockopt(sock_fd, SOL_SOCKET, SO_BUSY_POLL,
+			       (char *)&optval, sizeof(optval)))
+			WARN_LOG("SO_BUSY_POLL failed. (errno=%d %m)\n",
+				 xio_get_last_socket_error());
+#ifdef SO_PREFER_BUSY_POLL
+		optval = 1;
+		if (setsockopt(sock_fd, SOL_SOCKET, SO_PREFER_BUSY_POLL,
+			       (char *)&optval, sizeof(optval)))
+			WARN_LOG("SO_PREFER_BUSY_POLL failed. (errno=%d %m)\n",
+				 xio_get_last_socket_error());
+#endif
+	}
+#endif
+
 	return sock_fd;
 
 cleanup:
@@ -672,6 +1156,7 @@ struct xio_ucx_transport *xio_ucx_tcp_create(
 		int			create_tcp_socket)
 {
 	struct xio_ucx_transport	*ucx_hndl;
+	uint32_t			nbuckets, i;
 
 	/*allocate ucx handl */
 	ucx_hndl = (struct xio_ucx_transport *)
@@ -708,15 +1193,66 @@ struct xio_ucx_transport *xio_ucx_tcp_create(
 	ucx_hndl->tx_ready_tasks_num = 0;
 	ucx_hndl->tx_comp_cnt = 0;
 
+	/* batch sizes start at the compile time maximum */
+	ucx_hndl->tx_batch		= TX_BATCH;
+	ucx_hndl->rx_batch		= RX_BATCH;
+	ucx_hndl->comp_batch		= COMPLETION_BATCH_MAX;
+
 	memset(&ucx_hndl->tmp_work, 0, sizeof(struct xio_ucx_work_req));
 	ucx_hndl->tmp_work.msg_iov = ucx_hndl->tmp_iovec;
 
+	ucx_hndl->mpsc_efd = -1;
+
+	/* both indexes are sized to the send queue depth */
+	nbuckets = 64;
+	while (nbuckets < (uint32_t)g_options.snd_queue_depth_msgs)
+		nbuckets <<= 1;
+
+	/* (sn, stag) index of outstanding requests, for cancel */
+	ucx_hndl->cancel_hash = (struct list_head *)
+			ucalloc(nbuckets, sizeof(struct list_head));
+	if (!ucx_hndl->cancel_hash) {
+		xio_set_error(ENOMEM);
+		ERROR_LOG("ucalloc failed. %m\n");
+		goto cleanup;
+	}
+	for (i = 0; i < nbuckets; i++)
+		INIT_LIST_HEAD(&ucx_hndl->cancel_hash[i]);
+	ucx_hndl->cancel_hash_mask = nbuckets - 1;
+
+	/* wire sn -> sent task, sn is 16 bit so keep the mask within it */
+	nbuckets = min(nbuckets, 65536U);
+	ucx_hndl->sn_index = (struct xio_task **)
+			ucalloc(nbuckets, sizeof(struct xio_task *));
+	if (!ucx_hndl->sn_index) {
+		xio_set_error(ENOMEM);
+		ERROR_LOG("ucalloc failed. %m\n");
+		goto cleanup;
+	}
+	ucx_hndl->sn_index_mask = nbuckets - 1;
+
+	/* per connection wakeup for xio_ucx_send_mt */
+	ucx_hndl->mpsc_efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (ucx_hndl->mpsc_efd < 0) {
+		xio_set_error(xio_get_last_socket_error());
+		ERROR_LOG("eventfd failed. %m\n");
+		goto cleanup;
+	}
+
 	/* create ucx socket */
 	if (create_tcp_socket) {
 		memcpy(&ucx_hndl->tcp_sock.ops, &ucp,
 				sizeof(ucx_hndl->tcp_sock.ops));
 		if (ucx_hndl->tcp_sock.ops.open(&ucx_hndl->tcp_sock))
 			goto cleanup;
+		ucx_hndl->so_sndbuf =
+			xio_ucx_sockbuf_initial(ucx_options.ucx_so_sndbuf);
+		ucx_hndl->so_rcvbuf =
+			xio_ucx_sockbuf_initial(ucx_options.ucx_so_rcvbuf);
+		__sync_fetch_and_add(&ucx_so_sndbuf_inuse,
+				     ucx_hndl->so_sndbuf);
+		__sync_fetch_and_add(&ucx_so_rcvbuf_inuse,
+				     ucx_hndl->so_rcvbuf);
 	}
 	/* from now on don't allow changes */
 	ucx_hndl->max_inline_buf_sz	= xio_ucx_get_inline_buffer_size();
@@ -728,6 +1264,7 @@ struct xio_ucx_transport *xio_ucx_tcp_create(
 
 	INIT_LIST_HEAD(&ucx_hndl->in_flight_list);
 	INIT_LIST_HEAD(&ucx_hndl->tx_ready_list);
+	INIT_LIST_HEAD(&ucx_hndl->tx_credit_list);
 	INIT_LIST_HEAD(&ucx_hndl->tx_comp_list);
 	INIT_LIST_HEAD(&ucx_hndl->rx_list);
 	INIT_LIST_HEAD(&ucx_hndl->io_list);
@@ -751,6 +1288,12 @@ struct xio_ucx_transport *xio_ucx_tcp_create(
 	return ucx_hndl;
 
 cleanup:
+	if (ucx_hndl->mpsc_efd >= 0)
+		close(ucx_hndl->mpsc_efd);
+	if (ucx_hndl->sn_index)
+		ufree(ucx_hndl->sn_index);
+	if (ucx_hndl->cancel_hash)
+		ufree(ucx_hndl->cancel_hash);
 	ufree(ucx_hndl);
 
 	return NULL;
@@ -1001,6 +1544,52 @@ void xio_ucx_listener_ev_handler(int fd, int events, void *user_context)
 	}
 }
 
+/*---------------------------------------------------------------------------*/
+/* xio_ucx_set_reuseport						     */
+/*---------------------------------------------------------------------------*/
+static int xio_ucx_set_reuseport(int fd)
+{
+	int optval = 1;
+
+#ifdef SO_REUSEPORT
+	if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT,
+		       (char *)&optval, sizeof(optval))) {
+		xio_set_error(xio_get_last_socket_error());
+		ERROR_LOG("setsockopt SO_REUSEPORT failed. (errno=%d %m)\n",
+			  xio_get_last_socket_error());
+		return -1;
+	}
+#else
+	xio_set_error(ENOTSUP);
+	ERROR_LOG("SO_REUSEPORT is not supported\n");
+	return -1;
+#endif
+
+#ifdef SO_ATTACH_REUSEPORT_CBPF
+	if (ucx_options.ucx_reuseport > 1) {
+		/* pick the listener whose index matches the receiving cpu.
+		 * contexts must bind in cpu order; an out of range index
+		 * makes the kernel fall back to hashing
+		 */
+		struct sock_filter code[] = {
+			{ BPF_LD  | BPF_W | BPF_ABS, 0, 0,
+			  SKF_AD_OFF + SKF_AD_CPU },
+			{ BPF_RET | BPF_A, 0, 0, 0 },
+		};
+		struct sock_fprog prog = {
+			.len	= sizeof(code) / sizeof(code[0]),
+			.filter	= code,
+		};
+
+		if (setsockopt(fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF,
+			       &prog, sizeof(prog)))
+			ERROR_LOG("attach reuseport cbpf failed. (errno=%d %m)\n",
+				  xio_get_last_socket_error());
+	}
+#endif
+	return 0;
+}
+
 /**
  * server listens to incoming connections
  * @param transport - transport to listen to
@@ -1032,6 +1621,13 @@ static int xio_ucx_listen(struct xio_transport_base *transport,
 	}
 	ucx_hndl->base.is_client = 0;
 
+	/* sharded listen - every context binds its own socket to the portal */
+	if (ucx_options.ucx_reuseport) {
+		retval = xio_ucx_set_reuseport(ucx_hndl->tcp_sock.cfd);
+		if (retval)
+			goto exit1;
+	}
+
 	/* bind */
 	retval = bind(ucx_hndl->tcp_sock.cfd, (struct sockaddr *)&sa.sa_stor,
 			sa_len);
@@ -1157,11 +1753,18 @@ void xio_ucx_conn_established_helper(int fd, struct xio_ucx_transport *ucx_hndl,
 				xio_get_last_socket_error());
 		goto cleanup;
 	}
-	retval = xio_context_del_ev_handler(ucx_hndl->base.ctx, fd);
-
-	if (retval)
-		goto cleanup;
 	retval = xio_ucx_send_connect_msg(ucx_hndl->tcp_sock.cfd, msg);
+	if (retval == 1) {
+		/* socket not writable yet - come back on the next POLLOUT */
+		retval = xio_context_modify_ev_handler(
+				ucx_hndl->base.ctx, fd,
+				XIO_POLLOUT | XIO_POLLRDHUP | XIO_ONESHOT);
+		if (retval)
+			goto cleanup;
+		return;
+	}
+	if (xio_context_del_ev_handler(ucx_hndl->base.ctx, fd) && !retval)
+		retval = -1;
 	if (retval) {
 		ERROR_LOG("setting connection handler failed. (errno=%d %m)\n",
 			  xio_get_last_socket_error());
@@ -1685,6 +2288,8 @@ static void xio_ucx_task_init(struct xio_task *task,
 
 	xio_ucx_rxd_init(&ucx_task->rxd, buf, size);
 	xio_ucx_txd_init(&ucx_task->txd, buf, size);
+	ucx_task->task = task;
+	INIT_LIST_HEAD(&ucx_task->cancel_list_entry);
 
 	/* initialize the mbuf */
 	xio_mbuf_init(&task->mbuf, buf, size, 0);
@@ -1904,7 +2509,19 @@ static int xio_ucx_task_pre_put(
 	ucx_task->req_in_num_sge	= 0;
 	ucx_task->req_out_num_sge	= 0;
 	ucx_task->rsp_out_num_sge	= 0;
+	if (ucx_hndl->sn_index &&
+	    ucx_hndl->sn_index[ucx_task->sn & ucx_hndl->sn_index_mask] == task)
+		ucx_hndl->sn_index[ucx_task->sn & ucx_hndl->sn_index_mask] =
+									NULL;
+	if (ucx_hndl->setup_task == task)
+		ucx_hndl->setup_task = NULL;
+	if (ucx_hndl->tx_setup_task == task)
+		ucx_hndl->tx_setup_task = NULL;
 	ucx_task->sn			= 0;
+	ucx_task->tx_credit_held	= 0;
+	ucx_task->tx_credit_parked	= 0;
+	ucx_task->cancel_sent		= 0;
+	list_del_init(&ucx_task->cancel_list_entry);
 
 	ucx_task->out_ucx_op		= XIO_UCX_NULL;
 
@@ -1917,6 +2534,14 @@ static int xio_ucx_task_pre_put(
 
 	xio_ctx_del_work(ucx_hndl->base.ctx, &ucx_task->comp_work);
 
+	/* receive stopped for lack of tasks - resume now that one is back */
+	if (ucx_hndl->rx_pool_starved) {
+		ucx_hndl->rx_pool_starved = 0;
+		if (ucx_hndl->state == XIO_TRANSPORT_STATE_CONNECTED)
+			xio_context_add_event(ucx_hndl->base.ctx,
+					      &ucx_hndl->ctl_rx_event);
+	}
+
 	return 0;
 }
 
@@ -2175,6 +2800,66 @@ static int xio_ucx_set_opt(void *xio_obj,
 		VALIDATE_SZ(sizeof(int));
 		ucx_options.max_out_iovsz = *((int *)optval);
 		return 0;
+	case XIO_OPTNAME_UCX_EDGE_TRIGGERED:
+		VALIDATE_SZ(sizeof(int));
+		ucx_options.ucx_edge_triggered = *((int *)optval);
+		return 0;
+	case XIO_OPTNAME_UCX_BUSY_POLL:
+		VALIDATE_SZ(sizeof(int));
+		ucx_options.ucx_busy_poll = *((int *)optval);
+		return 0;
+	case XIO_OPTNAME_UCX_REUSEPORT:
+		VALIDATE_SZ(sizeof(int));
+		ucx_options.ucx_reuseport = *((int *)optval);
+		return 0;
+	case XIO_OPTNAME_UCX_SO_AUTOTUNE:
+		VALIDATE_SZ(sizeof(int));
+		ucx_options.ucx_so_autotune = *((int *)optval);
+		return 0;
+	case XIO_OPTNAME_UCX_BATCH_LAT_USEC:
+		VALIDATE_SZ(sizeof(int));
+		ucx_options.ucx_batch_lat_usec = *((int *)optval);
+		return 0;
+	case XIO_OPTNAME_UCX_TX_COPY_THRESHOLD:
+		VALIDATE_SZ(sizeof(int));
+		ucx_options.ucx_tx_copy_threshold = *((int *)optval);
+		return 0;
+	case XIO_OPTNAME_UCX_COALESCE_MSGS:
+		VALIDATE_SZ(sizeof(int));
+		ucx_options.ucx_coalesce_msgs = *((int *)optval);
+		return 0;
+	case XIO_OPTNAME_UCX_COALESCE_BYTES:
+		VALIDATE_SZ(sizeof(int));
+		ucx_options.ucx_coalesce_bytes = *((int *)optval);
+		return 0;
+	case XIO_OPTNAME_UCX_FLOW_CREDITS:
+		VALIDATE_SZ(sizeof(int));
+		ucx_options.ucx_flow_credits = *((int *)optval);
+		return 0;
+	case XIO_OPTNAME_UCX_COMP_DEADLINE_MSEC:
+		VALIDATE_SZ(sizeof(int));
+		ucx_options.ucx_comp_deadline_msec = *((int *)optval);
+		return 0;
+	case XIO_OPTNAME_UCX_TX_PRIO_WEIGHT:
+		VALIDATE_SZ(sizeof(int));
+		ucx_options.ucx_tx_prio_weight = *((int *)optval);
+		return 0;
+	case XIO_OPTNAME_UCX_TX_PASS_BYTES:
+		VALIDATE_SZ(sizeof(int));
+		ucx_options.ucx_tx_pass_bytes = *((int *)optval);
+		return 0;
+	case XIO_OPTNAME_UCX_RX_QUANTUM_USEC:
+		VALIDATE_SZ(sizeof(int));
+		ucx_options.ucx_rx_quantum_usec = *((int *)optval);
+		return 0;
+	case XIO_OPTNAME_UCX_SO_SNDBUF:
+		VALIDATE_SZ(sizeof(int));
+		ucx_options.ucx_so_sndbuf = *((int *)optval);
+		return 0;
+	case XIO_OPTNAME_UCX_SO_RCVBUF:
+		VALIDATE_SZ(sizeof(int));
+		ucx_options.ucx_so_rcvbuf = *((int *)optval);
+		return 0;
 	default:
 		break;
 	}
@@ -2205,6 +2890,90 @@ static int xio_ucx_get_opt(void  *xio_obj,
 		*((int *)optval) = ucx_options.max_out_iovsz;
 		*optlen = sizeof(int);
 		return 0;
+	case XIO_OPTNAME_UCX_EDGE_TRIGGERED:
+		*((int *)optval) = ucx_options.ucx_edge_triggered;
+		*optlen = sizeof(int);
+		return 0;
+	case XIO_OPTNAME_UCX_BUSY_POLL:
+		*((int *)optval) = ucx_options.ucx_busy_poll;
+		*optlen = sizeof(int);
+		return 0;
+	case XIO_OPTNAME_UCX_REUSEPORT:
+		*((int *)optval) = ucx_options.ucx_reuseport;
+		*optlen = sizeof(int);
+		return 0;
+	case XIO_OPTNAME_UCX_SO_AUTOTUNE:
+		*((int *)optval) = ucx_options.ucx_so_autotune;
+		*optlen = sizeof(int);
+		return 0;
+	case XIO_OPTNAME_UCX_SO_SNDBUF:
+		*((int *)optval) = ucx_options.ucx_so_sndbuf;
+		*optlen = sizeof(int);
+		return 0;
+	case XIO_OPTNAME_UCX_SO_RCVBUF:
+		*((int *)optval) = ucx_options.ucx_so_rcvbuf;
+		*optlen = sizeof(int);
+		return 0;
+	case XIO_OPTNAME_UCX_SO_SNDBUF_INUSE:
+		*((uint64_t *)optval) = ucx_so_sndbuf_inuse;
+		*optlen = sizeof(uint64_t);
+		return 0;
+	case XIO_OPTNAME_UCX_SO_RCVBUF_INUSE:
+		*((uint64_t *)optval) = ucx_so_rcvbuf_inuse;
+		*optlen = sizeof(uint64_t);
+		return 0;
+	case XIO_OPTNAME_UCX_TX_SPIN_WASTED:
+		*((uint64_t *)optval) = ucx_tx_spin_wasted;
+		*optlen = sizeof(uint64_t);
+		return 0;
+	case XIO_OPTNAME_UCX_BATCH_LAT_USEC:
+		*((int *)optval) = ucx_options.ucx_batch_lat_usec;
+		*optlen = sizeof(int);
+		return 0;
+	case XIO_OPTNAME_UCX_TX_COPY_THRESHOLD:
+		*((int *)optval) = ucx_options.ucx_tx_copy_threshold;
+		*optlen = sizeof(int);
+		return 0;
+	case XIO_OPTNAME_UCX_COALESCE_MSGS:
+		*((int *)optval) = ucx_options.ucx_coalesce_msgs;
+		*optlen = sizeof(int);
+		return 0;
+	case XIO_OPTNAME_UCX_COALESCE_BYTES:
+		*((int *)optval) = ucx_options.ucx_coalesce_bytes;
+		*optlen = sizeof(int);
+		return 0;
+	case XIO_OPTNAME_UCX_FLOW_CREDITS:
+		*((int *)optval) = ucx_options.ucx_flow_credits;
+		*optlen = sizeof(int);
+		return 0;
+	case XIO_OPTNAME_UCX_COMP_DEADLINE_MSEC:
+		*((int *)optval) = ucx_options.ucx_comp_deadline_msec;
+		*optlen = sizeof(int);
+		return 0;
+	case XIO_OPTNAME_UCX_TX_PRIO_WEIGHT:
+		*((int *)optval) = ucx_options.ucx_tx_prio_weight;
+		*optlen = sizeof(int);
+		return 0;
+	case XIO_OPTNAME_UCX_TX_PASS_BYTES:
+		*((int *)optval) = ucx_options.ucx_tx_pass_bytes;
+		*optlen = sizeof(int);
+		return 0;
+	case XIO_OPTNAME_UCX_RX_QUANTUM_USEC:
+		*((int *)optval) = ucx_options.ucx_rx_quantum_usec;
+		*optlen = sizeof(int);
+		return 0;
+	case XIO_OPTNAME_UCX_BATCH_GROW_CNT:
+		*((uint64_t *)optval) = ucx_batch_grow_cnt;
+		*optlen = sizeof(uint64_t);
+		return 0;
+	case XIO_OPTNAME_UCX_BATCH_SHRINK_CNT:
+		*((uint64_t *)optval) = ucx_batch_shrink_cnt;
+		*optlen = sizeof(uint64_t);
+		return 0;
+	case XIO_OPTNAME_UCX_TX_SENDMSG_CNT:
+		*((uint64_t *)optval) = ucx_tx_sendmsg_cnt;
+		*optlen = sizeof(uint64_t);
+		return 0;
 	default:
 		break;
 	}
@@ -2349,10 +3118,14 @@ static void init_xio_ucx_transport(void)
 	xio_ucx_transport.dup2 = xio_ucx_dup2;
 	/*	.update_task		= xio_ucx_update_task;*/
 	xio_ucx_transport.send = xio_ucx_send;
+	xio_ucx_transport.send_batch = xio_ucx_send_batch;
+	xio_ucx_transport.send_mt = xio_ucx_send_mt;
 	xio_ucx_transport.poll = xio_ucx_poll;
+	xio_ucx_transport.poll_completions = xio_ucx_poll_completions;
 	xio_ucx_transport.set_opt = xio_ucx_set_opt;
 	xio_ucx_transport.get_opt = xio_ucx_get_opt;
 	xio_ucx_transport.cancel_req = xio_ucx_cancel_req;
+	xio_ucx_transport.cancel_all_req = xio_ucx_cancel_all_req;
 	xio_ucx_transport.cancel_rsp = xio_ucx_cancel_rsp;
 	xio_ucx_transport.get_pools_setup_ops = xio_ucx_get_pools_ops;
 	xio_ucx_transport.set_pools_cls = xio_ucx_set_pools_cls;